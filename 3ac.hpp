@@ -2,10 +2,13 @@
 #define CSHANTY_3AC_HPP
 
 #include <assert.h>
+#include <deque>
 #include <list>
 #include <map>
+#include <ostream>
 #include <set>
 #include <string.h>
+#include <vector>
 #include "symbol_table.hpp"
 #include "types.hpp"
 
@@ -15,104 +18,99 @@ class TypeAnalysis;
 class Procedure;
 class IRProgram;
 
-//target of a jump
-class Label{
-public:
-	Label(std::string nameIn){
-		this->name = nameIn;
-	}
-	std::string getName(){
-		return name;
-	}
-private:
-	std::string name;
+//Labels are referred to by number. Numbered labels are
+// handed out by the IRProgram and print as lbl_N; the 
+// entry label of each procedure prints as its name.
+typedef uint32_t LabelID;
+static const LabelID NO_LABEL = UINT32_MAX;
+static const LabelID ENTRY_LABEL = UINT32_MAX - 1;
+
+//Operands are referred to by their index in their 
+// procedure's operand table
+typedef uint32_t OpdID;
+static const OpdID NO_OPD = UINT32_MAX;
+
+enum class OpdKind : uint8_t{
+	SYM,   //a variable (local, formal or global) or function
+	TMP,   //a temporary made by makeTmp (varTmpN)
+	ADDR,  //an address temporary (addrTmpN)
+	STR,   //the address of a string literal (str_N)
+	LIT,   //an integer constant
+	REG    //a machine register, after register allocation (rN)
 };
 
+//One entry in a procedure's operand table. Entries are
+// small values; an operand's printed name is only built 
+// when it is written out.
 class Opd{
 public:
-	Opd(size_t widthIn) : myWidth(widthIn){}
-	virtual std::string valString() = 0;
-	virtual std::string locString() = 0;
-	virtual size_t getWidth(){ return myWidth; }
-	static size_t width(const DataType * type){
-		if (const BasicType * basic = type->asBasic()){
-			return 8;
-		}
-		assert(false);
+	static Opd sym(SemSymbol * symIn, size_t width){
+		Opd res(OpdKind::SYM, width, 0);
+		res.mySym = symIn;
+		return res;
 	}
-private:
-	size_t myWidth;
-};
-
-//variables
-class SymOpd : public Opd{
-public:
-	virtual std::string valString() override{
-		return "[" + mySym->getName() + "]";
+	static Opd lit(int64_t valueIn, size_t width){
+		Opd res(OpdKind::LIT, width, 0);
+		res.myValue = valueIn;
+		return res;
 	}
-	virtual std::string locString() override{
-		return mySym->getName();
+	//A numbered operand: TMP, ADDR, STR or REG
+	static Opd numbered(OpdKind kindIn, uint32_t numIn, size_t width){
+		return Opd(kindIn, width, numIn);
 	}
-	virtual std::string getName(){
-		return mySym->getName();
-	}
-	const SemSymbol * getSym(){ return mySym; }
-private:
-	//Private Constructor
-	SymOpd(SemSymbol * sym, size_t width)
-	: Opd(width), mySym(sym) {} 
-	SemSymbol * mySym;
-	friend class Procedure;
-	friend class IRProgram;
-};
-
-class LitOpd : public Opd{
-public:
-	LitOpd(std::string valIn, size_t width)
-	: Opd(width), val(valIn){ }
-	virtual std::string valString() override { return val; }
-	virtual std::string locString() override { 
-		throw InternalError("Tried to get location of a constant");
+	//An SSA version of a variable (printed as x.N). The
+	// version goes in whichever field the kind leaves free.
+	static Opd version(const Opd& base, uint32_t versionIn){
+		Opd res = base;
+		if (base.myKind == OpdKind::SYM){
+			res.myNum = versionIn;
+		} else {
+			res.myVersion = versionIn;
+		}
+		return res;
 	}
-private:
-	std::string val;
-	std::string name;
-};
 
-//temps
-class AuxOpd : public Opd{
-public:
-	AuxOpd(std::string nameIn, size_t width) 
-	: Opd(width), name(nameIn) { }
-	virtual std::string valString() override{
-		return "[" + getName() + "]";
+	OpdKind getKind() const { return myKind; }
+	size_t getWidth() const { return myWidth; }
+	bool isLit() const { return myKind == OpdKind::LIT; }
+	SemSymbol * getSym() const { 
+		return myKind == OpdKind::SYM ? mySym : nullptr; 
 	}
-	virtual std::string locString() override{
-		return getName();
+	int64_t getValue() const { return myValue; }
+	uint32_t getNum() const { return myNum; }
+	//The SSA version, or 0 for the variable itself
+	uint32_t getVersion() const {
+		if (myKind == OpdKind::SYM){ return myNum; }
+		if (myKind == OpdKind::LIT){ return 0; }
+		return myVersion;
 	}
-	std::string getName(){
-		return name;
-	}
-private:
-	std::string name;
-};
 
-class AddrOpd : public Opd{
-public:
-	AddrOpd(std::string nameIn, size_t width)
-	: Opd(width), name(nameIn) { }
-	virtual std::string valString() override{
-		return "[" + getName() + "]";
-	}
-	virtual std::string locString() override{
-		return getName();
-	}
-	virtual std::string getName(){
-		return name;
+	//Write the operand's value (e.g. [x] or 4)
+	void writeVal(std::ostream& out) const;
+	//Write the operand's location (e.g. x); constants have none
+	void writeLoc(std::ostream& out) const;
+	std::string valString() const;
+	std::string locString() const;
+
+	static size_t width(const DataType * type){
+		if (const BasicType * basic = type->asBasic()){
+			return 8;
+		}
+		assert(false);
 	}
 private:
-	std::string val;
-	std::string name;
+	Opd(OpdKind kindIn, size_t widthIn, uint32_t numIn)
+	: myKind(kindIn), myWidth(static_cast<uint8_t>(widthIn)), 
+	  myNum(numIn), myValue(0){ }
+
+	OpdKind myKind;
+	uint8_t myWidth;
+	uint32_t myNum;
+	union{
+		SemSymbol * mySym;
+		int64_t myValue;
+		uint32_t myVersion;
+	};
 };
 
 enum BinOp {
@@ -122,211 +120,319 @@ enum UnaryOp{
 	NEG64, NOT8
 };
 
+//The kinds of quad. Each subclass of Quad below just 
+// builds a Quad of one of these kinds.
+enum class QuadOp : uint8_t{
+	ASSIGN, BINOP, UNARYOP, INDEX, GOTO, IFZ, NOP, REPORT, RECEIVE,
+	CALL, ENTER, LEAVE, SETARG, GETARG, SETRET, GETRET, PHI
+};
+
+//A single 3AC instruction. Quads are small, fixed-size 
+// records stored by value in their procedure's body, so a
+// pass over a procedure walks one contiguous array. Which
+// fields are meaningful depends on the opcode:
+//  - dst/src1/src2 are operand ids (NO_OPD when unused).
+//    dst is the operand the quad writes and src1/src2 are
+//    the ones it reads, so analyses can find a quad's defs
+//    and uses without switching on the opcode.
+//  - sub holds the BinOp or UnaryOp, or the BaseType of the
+//    value a REPORT/RECEIVE moves
+//  - aux holds a jump target (GOTO/IFZ), an argument 
+//    index (SETARG/GETARG) or a phi number (PHI)
+//  - label is the label attached to the quad, if any
+//Comments are kept by the Procedure, not in the quad.
 class Quad{
 public:
-	Quad();
-	void addLabel(Label * label);
-	Label * getLabel(){ return labels.front(); }
-	virtual std::string repr() = 0;
-	std::string commentStr();
-	virtual std::string toString(bool verbose=false);
-	void setComment(std::string commentIn);
-private:
-	std::string myComment;
-	std::list<Label *> labels;
+	QuadOp getOp() const { return op; }
+	//Whether the quad does anything besides writing its dst:
+	// calls, input and output, control flow and the steps of
+	// the calling convention. Quads without side effects may
+	// be deleted once nothing reads their dst.
+	bool hasSideEffects() const;
+	void addLabel(LabelID labelIn){
+		if (labelIn == NO_LABEL){ return; }
+		if (label != NO_LABEL){
+			throw new InternalError("Quad already has a label");
+		}
+		label = labelIn;
+	}
+	LabelID getLabel() const { return label; }
+	//Detach the label (e.g. to move it onto a quad inserted
+	// in front of this one), returning it
+	LabelID takeLabel(){
+		LabelID res = label;
+		label = NO_LABEL;
+		return res;
+	}
+	OpdID getDst() const { return dst; }
+	OpdID getSrc1() const { return src1; }
+	OpdID getSrc2() const { return src2; }
+	//The single source of quads with one (e.g. AssignQuad)
+	OpdID getSrc() const { return src1; }
+	//Operands can be rewritten in place, e.g. to rename a
+	// variable; the opcode and the rest stay as they are
+	void setDst(OpdID opd){ dst = opd; }
+	void setSrc1(OpdID opd){ src1 = opd; }
+	void setSrc2(OpdID opd){ src2 = opd; }
+	LabelID getTarget() const { return aux; }
+	size_t getIndex() const { return aux; }
+	BinOp getBinOp() const { return static_cast<BinOp>(sub); }
+	UnaryOp getUnaryOp() const { return static_cast<UnaryOp>(sub); }
+	const DataType * getType() const { 
+		return BasicType::produce(static_cast<BaseType>(sub)); 
+	}
+
+	//Write the quad as one line of 3AC, without the newline.
+	// Operands and labels are named through proc.
+	void emit(std::ostream& out, Procedure * proc) const;
+	//Write the quad's instruction text (without labels)
+	void repr(std::ostream& out, Procedure * proc) const;
+	std::string toString(Procedure * proc) const;
+protected:
+	Quad(QuadOp opIn, OpdID dstIn = NO_OPD, 
+		OpdID src1In = NO_OPD, OpdID src2In = NO_OPD)
+	: op(opIn), sub(0), label(NO_LABEL), 
+	  dst(dstIn), src1(src1In), src2(src2In), aux(0){ }
+	QuadOp op;
+	uint8_t sub;
+	LabelID label;
+	OpdID dst;
+	OpdID src1;
+	OpdID src2;
+	uint32_t aux;
 };
 
 class BinOpQuad : public Quad{
 public:
-	BinOpQuad(Opd * dstIn, BinOp oprIn, Opd * src1In, Opd * src2In);
-	std::string repr() override;
-	static std::string oprString(BinOp opr);
-private:
-	Opd * dst;
-	BinOp opr;
-	Opd * src1;
-	Opd * src2;
+	BinOpQuad(OpdID dstIn, BinOp oprIn, OpdID src1In, OpdID src2In)
+	: Quad(QuadOp::BINOP, dstIn, src1In, src2In){
+		sub = static_cast<uint8_t>(oprIn);
+	}
+	static const char * oprString(BinOp opr);
 };
 
 class UnaryOpQuad : public Quad {
 public:
-	UnaryOpQuad(Opd * dstIn, UnaryOp opIn, Opd * srcIn);
-	std::string repr() override ;
-	Opd * getDst(){ return dst; }
-	Opd * getSrc(){ return src; }
-	UnaryOp getOp(){ return op; }
-private:
-	Opd * dst;
-	UnaryOp op;
-	Opd * src;
+	UnaryOpQuad(OpdID dstIn, UnaryOp opIn, OpdID srcIn)
+	: Quad(QuadOp::UNARYOP, dstIn, srcIn){
+		sub = static_cast<uint8_t>(opIn);
+	}
 };
 
 class AssignQuad : public Quad{
-	
 public:
-	AssignQuad(Opd * dstIn, Opd * srcIn);
-	std::string repr() override;
-	Opd * getDst(){ return dst; }
-	Opd * getSrc(){ return src; }
-private:
-	Opd * dst;
-	Opd * src;
+	AssignQuad(OpdID dstIn, OpdID srcIn)
+	: Quad(QuadOp::ASSIGN, dstIn, srcIn){ }
 };
 
-
 class IndexQuad : public Quad{
 public:
-	IndexQuad(AddrOpd * dstIn, Opd * srcIn, Opd * offIn)
-	: dst(dstIn), src(srcIn), off(offIn){
-	}
-	std::string repr() override;
-private:
-	AddrOpd * dst;
-	Opd * src;
-	Opd * off;
+	IndexQuad(OpdID dstIn, OpdID srcIn, OpdID offIn)
+	: Quad(QuadOp::INDEX, dstIn, srcIn, offIn){ }
 };
 
 class GotoQuad : public Quad {
 public:
-	GotoQuad(Label * tgtIn);
-	std::string repr() override;
-	Label * getTarget(){ return tgt; }
-private:
-	Label * tgt;
+	GotoQuad(LabelID tgtIn) : Quad(QuadOp::GOTO){ aux = tgtIn; }
 };
 
 class IfzQuad : public Quad {
 public:
-	IfzQuad(Opd * cndIn, Label * tgtIn);
-	std::string repr() override;
-	Label * getTarget(){ return tgt; }
-	Opd * getCnd(){ return cnd; }
-private:
-	Opd * cnd;
-	Label * tgt;
+	IfzQuad(OpdID cndIn, LabelID tgtIn)
+	: Quad(QuadOp::IFZ, NO_OPD, cndIn){ aux = tgtIn; }
 };
 
 class NopQuad : public Quad {
 public:
-	NopQuad();
-	std::string repr() override;
+	NopQuad() : Quad(QuadOp::NOP){ }
 };
 
 class ReportQuad : public Quad {
 public:
-	ReportQuad(Opd * arg, const DataType * type);
-	std::string repr() override;
-	Opd * getSrc(){ return myArg; }
-	const DataType * getType(){ return myType; }
-private:
-	Opd * myArg;
-	const DataType * myType;
+	ReportQuad(OpdID arg, const DataType * type)
+	: Quad(QuadOp::REPORT, NO_OPD, arg){ 
+		sub = baseOf(type);
+	}
+	static uint8_t baseOf(const DataType * type){
+		const BasicType * basic = type->asBasic();
+		if (basic == nullptr){
+			throw new InternalError("I/O of a non-basic type");
+		}
+		return static_cast<uint8_t>(basic->getBaseType());
+	}
 };
 
 class ReceiveQuad : public Quad {
 public:
-	ReceiveQuad(Opd * arg, const DataType * type);
-	std::string repr() override;
-	Opd * getDst(){ return myArg; }
-private:
-	Opd * myArg;
-	const DataType * myType;
+	ReceiveQuad(OpdID arg, const DataType * type)
+	: Quad(QuadOp::RECEIVE, arg){ 
+		sub = ReportQuad::baseOf(type);
+	}
 };
 
+//The callee is named by an operand for its function symbol
+// (see Procedure::getSymOpd)
 class CallQuad : public Quad{
 public:
-	CallQuad(SemSymbol * calleeIn);
-	std::string repr() override;
-private:
-	SemSymbol * callee;
+	CallQuad(OpdID calleeIn) : Quad(QuadOp::CALL, NO_OPD, calleeIn){ }
 };
 
 class EnterQuad : public Quad{
 public:
-	EnterQuad(Procedure * proc);
-	virtual std::string repr() override;
-private:
-	Procedure * myProc;
+	EnterQuad() : Quad(QuadOp::ENTER){ }
 };
 
 class LeaveQuad : public Quad{
 public:
-	LeaveQuad(Procedure * proc);
-	virtual std::string repr() override;
-private:
-	Procedure * myProc;
+	LeaveQuad() : Quad(QuadOp::LEAVE){ }
 };
 
 class SetArgQuad : public Quad{
 public:
-	SetArgQuad(size_t indexIn, Opd * opdIn);
-	std::string repr() override;
-private:
-	size_t index;
-	Opd * opd;
+	SetArgQuad(size_t indexIn, OpdID opdIn)
+	: Quad(QuadOp::SETARG, NO_OPD, opdIn){ 
+		aux = static_cast<uint32_t>(indexIn); 
+	}
 };
 
 class GetArgQuad : public Quad{
 public:
-	GetArgQuad(size_t indexIn, Opd * opdIn);
-	std::string repr() override;
-	Opd * getDst(){ return opd; }
-private:
-	size_t index;
-	Opd * opd;
+	GetArgQuad(size_t indexIn, OpdID opdIn)
+	: Quad(QuadOp::GETARG, opdIn){ 
+		aux = static_cast<uint32_t>(indexIn); 
+	}
 };
 
 class SetRetQuad : public Quad{
 public:
-	SetRetQuad(Opd * opdIn);
-	std::string repr() override;
-	Opd * getSrc(){ return opd; }
-private:
-	Opd * opd;
+	SetRetQuad(OpdID opdIn) : Quad(QuadOp::SETRET, NO_OPD, opdIn){ }
 };
 
 class GetRetQuad : public Quad{
 public:
-	GetRetQuad(Opd * opdIn);
-	std::string repr() override;
-	Opd * getDst(){ return opd; }
-private:
-	Opd * opd;
+	GetRetQuad(OpdID opdIn) : Quad(QuadOp::GETRET, opdIn){ }
+};
+
+//A phi function, at the start of a block in SSA form. Its
+// dst is written with the argument for the predecessor that
+// control came from; the arguments are kept by the
+// Procedure, under the phi's number (see makePhi).
+class PhiQuad : public Quad{
+public:
+	PhiQuad(OpdID dstIn, uint32_t phiIn) : Quad(QuadOp::PHI, dstIn){
+		aux = phiIn;
+	}
 };
 
 class Procedure{
 public:
-	Procedure(IRProgram * prog, std::string name);
-	void addQuad(Quad * quad);
-	Quad * popQuad();
+	Procedure(IRProgram * prog, Ident name);
+	//Append a quad to the body, returning its index
+	size_t addQuad(const Quad& quad);
+	Quad popQuad();
+	//Overwrite the quad at idx, keeping its label
+	void replaceQuad(size_t idx, Quad quad);
+	//Delete every quad whose entry in dead is true, keeping
+	// the rest (and their comments) in order. A deleted quad
+	// whose label a surviving jump targets leaves a labeled
+	// nop behind, so the jump still lands.
+	void removeQuads(const std::vector<bool>& dead);
+	//Insert quads into the body. Each (idx, quad) pair puts
+	// quad just before body[idx] (at the end, for idx equal
+	// to the body's size), after anything already inserted
+	// there; pairs must be sorted by idx. Labels stay on the
+	// quads they were on, so a jump to body[idx] skips the
+	// quads inserted before it.
+	void insertQuads(const std::vector<std::pair<size_t, Quad>>& inserts);
 	IRProgram * getProg();
-	std::list<SymOpd *> getFormals() { return formals; }
-	SymOpd * getFormal(size_t idx);
-	cshanty::Label * makeLabel();
+	const std::vector<OpdID>& getFormals() const { return formals; }
+	const std::vector<OpdID>& getLocals() const { return locals; }
+	const std::vector<OpdID>& getTemps() const { return temps; }
+	OpdID getFormal(size_t idx);
+	LabelID makeLabel();
 
 	void gatherLocal(SemSymbol * sym);
 	void gatherFormal(SemSymbol * sym);
-	SymOpd * getSymOpd(SemSymbol * sym);
-	AuxOpd * makeTmp(size_t width);
-	AddrOpd * makeAddrOpd(size_t width);
+	//The operand for a variable or function symbol. Each 
+	// symbol has one operand per procedure.
+	OpdID getSymOpd(SemSymbol * sym);
+	OpdID makeTmp(size_t width);
+	OpdID makeAddrOpd(size_t width);
+	//Constants are shared: each distinct value (and width)
+	// has one operand per procedure
+	OpdID makeLit(int64_t val, size_t width);
+	//The address of the program-wide string literal val
+	OpdID makeString(std::string val);
+	const Opd& getOpd(OpdID id) const { return opds[id]; }
+	size_t numOpds() const { return opds.size(); }
+	//A new SSA version of the variable base. Versions are
+	// added to the temps, as that is what they become when
+	// the procedure leaves SSA form.
+	OpdID makeVersion(OpdID base, uint32_t version);
+	//The operand for register number reg (see regalloc.hpp).
+	// Each register has one operand per procedure.
+	OpdID getRegOpd(uint32_t reg);
+	//Forget the temps that no quad mentions any more, so
+	// they take no space in the frame. Returns how many.
+	size_t dropUnusedTemps();
+
+	//The body, in order, not including the enter and leave
+	// quads. Quads are stored by value; the vector may move
+	// them as it grows, so hold indices rather than pointers.
+	std::vector<Quad>& getBody(){ return body; }
+	const Quad& getEnter() const { return enter; }
+	const Quad& getLeave() const { return leave; }
+
+	//Phi arguments, only present in SSA form (see ssa.hpp).
+	// makePhi sets aside numArgs arguments, all NO_OPD, and
+	// returns the phi's number for a PhiQuad.
+	uint32_t makePhi(size_t numArgs);
+	OpdID * getPhiArgs(uint32_t phi){ return &phiArgs[phiStart[phi]]; }
+	size_t numPhiArgs(uint32_t phi) const {
+		return phiStart[phi + 1] - phiStart[phi];
+	}
+	void clearPhis();
+
+	void setComment(size_t quadIdx, std::string comment);
+	const std::string * getComment(size_t quadIdx) const;
 
-	std::string toString(bool verbose=false); 
+	//Write the name of a label (as seen from this procedure)
+	// to out, returning its length
+	size_t emitLabel(std::ostream& out, LabelID label);
+
+	void emit(std::ostream& out, bool verbose=false); 
+	//Write the procedure as x86-64 assembly (see
+	// x64_codegen.cpp). It must not be in SSA form.
+	void toX64(std::ostream& out);
 	std::string getName();
 
-	cshanty::Label * getLeaveLabel();
+	LabelID getLeaveLabel();
 private:
-	EnterQuad * enter;
-	LeaveQuad * leave;
-	Label * leaveLabel;
+	OpdID addOpd(const Opd& opd);
+
+	Quad enter;
+	Quad leave;
+	LabelID leaveLabel;
 
 	IRProgram * myProg;
-	std::map<SemSymbol *, SymOpd *> locals;
-	std::list<AuxOpd *> temps; 
-	std::list<SymOpd *> formals; 
-	std::list<AddrOpd *> addrOpds;
-	std::list<Quad *> * bodyQuads;
-	std::string myName;
-	size_t maxTmp;
+	//The operand table, indexed by OpdID
+	std::vector<Opd> opds;
+	HashMap<SemSymbol *, OpdID> symOpds;
+	HashMap<int64_t, OpdID> litOpds;
+	std::vector<OpdID> regOpds;
+	std::vector<OpdID> locals;
+	std::vector<OpdID> temps; 
+	std::vector<OpdID> formals; 
+	std::vector<OpdID> addrOpds;
+	std::vector<Quad> body;
+	//Arguments of every phi, flattened; phi N's are
+	// phiArgs[phiStart[N]] to phiArgs[phiStart[N + 1] - 1]
+	std::vector<OpdID> phiArgs;
+	std::vector<uint32_t> phiStart;
+	//Comments on body quads, by quad index
+	std::map<size_t, std::string> comments;
+	Ident myName;
+	uint32_t maxTmp;
 };
 
 class IRProgram{
@@ -334,26 +440,57 @@ public:
 	IRProgram(TypeAnalysis * taIn) : ta(taIn){
 		procs = new std::list<Procedure *>();
 	}
-	Procedure * makeProc(std::string name);
+	Procedure * makeProc(Ident name);
 	std::list<Procedure *> * getProcs();
-	Label * makeLabel();
-	Opd * makeString(std::string val);
+	LabelID makeLabel();
+	//How many numbered labels have been handed out
+	size_t numLabels() const { return max_label; }
+	//Intern a string literal, returning its number (str_N)
+	uint32_t makeString(std::string val);
 	void gatherGlobal(SemSymbol * sym);
-	SymOpd * getGlobal(SemSymbol * sym);
+	bool isGlobal(SemSymbol * sym);
+	//Record variables are lowered field by field: each field
+	// of a record variable is a variable of its own, named
+	// base.field. declareRecord makes those variables, as
+	// locals of proc, or as globals if proc is null, and
+	// fieldSym finds one of them.
+	void declareRecord(SemSymbol * base, Procedure * proc);
+	SemSymbol * fieldSym(SemSymbol * base, Ident field);
+	//Report a record used as a whole (passed, returned or
+	// declared as a formal), which 3AC has no lowering for
+	void errRecordValue(Position pos);
+	bool passed() const { return !hasError; }
+	const std::vector<SemSymbol *>& getGlobals(){ return globals; }
+	const std::vector<std::string>& getStrings(){ return strings; }
+	//The characters string literal num stands for: its text
+	// without the quotes, with the escapes decoded
+	std::string stringValue(uint32_t num) const;
 	size_t opWidth(ASTNode * node);
 	const DataType * nodeType(ASTNode * node);
-	std::set<Opd *> globalSyms();
 
-	std::string toString(bool verbose=false);
+	//Write the whole program as 3AC text. Output is streamed
+	// quad by quad, never held in memory all at once.
+	void emit(std::ostream& out, bool verbose=false);
+	//Write the whole program as x86-64 GNU assembly, to be
+	// linked against the runtime in stdcshanty.c
+	void toX64(std::ostream& out);
 private:
 	TypeAnalysis * ta;
-	size_t max_label = 0;
-	size_t str_idx = 0;
+	uint32_t max_label = 0;
 	std::list<Procedure *> * procs; 
-	HashMap<AddrOpd *, std::string> strings;
-	std::map<SemSymbol *, SymOpd *> globals;
+	//String literals, indexed by number, and deduplicated
+	std::vector<std::string> strings;
+	HashMap<std::string, uint32_t> stringIdx;
+	std::vector<SemSymbol *> globals;
+	std::set<SemSymbol *> globalSet;
+	//The variables standing for record fields, and their
+	// names, which no source identifier can clash with
+	std::deque<VarSymbol> fieldSyms;
+	HashMap<SemSymbol *, HashMap<Ident, SemSymbol *>> recordFields;
+	Interner fieldNames;
+	bool hasError = false;
 };
 
 }
 
-#endif 
+#endif
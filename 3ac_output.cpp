@@ -1,7 +1,25 @@
+#include <vector>
 #include "ast.hpp"
 
 namespace cshanty{
 
+//Labels are attached to a nop, so that a label can be the
+// target of a jump however the code after it is lowered
+static void addLabeledNop(Procedure * proc, LabelID label){
+	NopQuad nop;
+	nop.addLabel(label);
+	proc->addQuad(nop);
+}
+
+static OpdID flattenBinary(Procedure * proc, ExpNode * node, BinOp opr, 
+	ExpNode * lhs, ExpNode * rhs){
+	OpdID src1 = lhs->flatten(proc);
+	OpdID src2 = rhs->flatten(proc);
+	OpdID dst = proc->makeTmp(proc->getProg()->opWidth(node));
+	proc->addQuad(BinOpQuad(dst, opr, src1, src2));
+	return dst;
+}
+
 IRProgram * ProgramNode::to3AC(TypeAnalysis * ta){
 	IRProgram * prog = new IRProgram(ta);
 	for (auto global : *myGlobals){
@@ -11,7 +29,22 @@ IRProgram * ProgramNode::to3AC(TypeAnalysis * ta){
 }
 
 void FnDeclNode::to3AC(IRProgram * prog){
-	TODO(Implement me)
+	Procedure * proc = prog->makeProc(myID->getName());
+	const DataType * retType = myID->getSymbol()->getDataType()->asFn()->getReturnType();
+	if (retType->asRecord()){
+		prog->errRecordValue(myRetType->pos());
+	}
+	for (auto formal : *myFormals){
+		formal->to3AC(proc);
+	}
+	//Arguments are numbered from 1
+	size_t argIdx = 1;
+	for (OpdID formal : proc->getFormals()){
+		proc->addQuad(GetArgQuad(argIdx++, formal));
+	}
+	for (auto stmt : *myBody){
+		stmt->to3AC(proc);
+	}
 }
 
 void FnDeclNode::to3AC(Procedure * proc){
@@ -31,163 +64,254 @@ void FormalDeclNode::to3AC(IRProgram * prog){
 }
 
 void FormalDeclNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	SemSymbol * sym = ID()->getSymbol();
+	assert(sym != nullptr);
+	if (sym->getDataType()->asRecord()){
+		proc->getProg()->errRecordValue(pos());
+		return;
+	}
+	proc->gatherFormal(sym);
 }
 
 void RecordTypeDeclNode::to3AC(IRProgram * prog){
-	TODO(Implement me)
+	//A record declaration only introduces a type; there is
+	// no code or storage to generate for it
 }
 
 void RecordTypeDeclNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	//Records are only declared at global scope
+	throw new InternalError("Record declaration at a local scope");
 }
 
-Opd * IntLitNode::flatten(Procedure * proc){
+OpdID IntLitNode::flatten(Procedure * proc){
 	const DataType * type = proc->getProg()->nodeType(this);
-	return new LitOpd(std::to_string(myNum), 8);
+	return proc->makeLit(myNum, Opd::width(type));
 }
 
-Opd * StrLitNode::flatten(Procedure * proc){
-	Opd * res = proc->getProg()->makeString(myStr);
-	return res;
+OpdID StrLitNode::flatten(Procedure * proc){
+	return proc->makeString(myStr);
 }
 
-Opd * TrueNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID TrueNode::flatten(Procedure * proc){
+	return proc->makeLit(1, proc->getProg()->opWidth(this));
 }
 
-Opd * FalseNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID FalseNode::flatten(Procedure * proc){
+	return proc->makeLit(0, proc->getProg()->opWidth(this));
 }
 
-Opd * AssignExpNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID AssignExpNode::flatten(Procedure * proc){
+	OpdID src = mySrc->flatten(proc);
+	OpdID dst = myDst->flatten(proc);
+	proc->addQuad(AssignQuad(dst, src));
+	return dst;
 }
 
-Opd * LValNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID LValNode::flatten(Procedure * proc){
+	//Every concrete lval (IDNode, IndexNode) overrides this
+	throw new InternalError("Flattened an abstract lval");
 }
 
-Opd * CallExpNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID CallExpNode::flatten(Procedure * proc){
+	std::vector<OpdID> args;
+	for (auto arg : *myArgs){
+		args.push_back(arg->flatten(proc));
+	}
+	//Arguments are only set once all of them are computed,
+	// so a call within an argument can't clobber them
+	for (size_t i = 0; i < args.size(); i++){
+		proc->addQuad(SetArgQuad(i + 1, args[i]));
+	}
+	SemSymbol * fn = myID->getSymbol();
+	assert(fn != nullptr);
+	proc->addQuad(CallQuad(proc->getSymOpd(fn)));
+
+	const DataType * retType = fn->getDataType()->asFn()->getReturnType();
+	if (retType->isVoid()){ return NO_OPD; }
+	//Already reported at the callee's declaration
+	if (retType->asRecord()){ return proc->makeLit(0, 8); }
+	OpdID res = proc->makeTmp(Opd::width(retType));
+	proc->addQuad(GetRetQuad(res));
+	return res;
 }
 
-Opd * NegNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID NegNode::flatten(Procedure * proc){
+	OpdID src = myExp->flatten(proc);
+	OpdID dst = proc->makeTmp(proc->getProg()->opWidth(this));
+	proc->addQuad(UnaryOpQuad(dst, NEG64, src));
+	return dst;
 }
 
-Opd * NotNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID NotNode::flatten(Procedure * proc){
+	OpdID src = myExp->flatten(proc);
+	OpdID dst = proc->makeTmp(proc->getProg()->opWidth(this));
+	proc->addQuad(UnaryOpQuad(dst, NOT8, src));
+	return dst;
 }
 
-Opd * PlusNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID PlusNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, ADD64, myExp1, myExp2);
 }
 
-Opd * MinusNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID MinusNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, SUB64, myExp1, myExp2);
 }
 
-Opd * TimesNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID TimesNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, MULT64, myExp1, myExp2);
 }
 
-Opd * DivideNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID DivideNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, DIV64, myExp1, myExp2);
 }
 
-Opd * AndNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID AndNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, AND64, myExp1, myExp2);
 }
 
-Opd * OrNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID OrNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, OR64, myExp1, myExp2);
 }
 
-Opd * EqualsNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID EqualsNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, EQ64, myExp1, myExp2);
 }
 
-Opd * NotEqualsNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID NotEqualsNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, NEQ64, myExp1, myExp2);
 }
 
-Opd * LessNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID LessNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, LT64, myExp1, myExp2);
 }
 
-Opd * GreaterNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID GreaterNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, GT64, myExp1, myExp2);
 }
 
-Opd * LessEqNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID LessEqNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, LTE64, myExp1, myExp2);
 }
 
-Opd * GreaterEqNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID GreaterEqNode::flatten(Procedure * proc){
+	return flattenBinary(proc, this, GTE64, myExp1, myExp2);
 }
 
 void AssignStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	myExp->flatten(proc);
 }
 
 void PostIncStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	OpdID opd = myLVal->flatten(proc);
+	OpdID one = proc->makeLit(1, proc->getProg()->opWidth(myLVal));
+	proc->addQuad(BinOpQuad(opd, ADD64, opd, one));
 }
 
 void PostDecStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	OpdID opd = myLVal->flatten(proc);
+	OpdID one = proc->makeLit(1, proc->getProg()->opWidth(myLVal));
+	proc->addQuad(BinOpQuad(opd, SUB64, opd, one));
 }
 
 void ReceiveStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	OpdID dst = myDst->flatten(proc);
+	proc->addQuad(ReceiveQuad(dst, proc->getProg()->nodeType(myDst)));
 }
 
 void ReportStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	OpdID src = mySrc->flatten(proc);
+	proc->addQuad(ReportQuad(src, proc->getProg()->nodeType(mySrc)));
 }
 
 void IfStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	LabelID after = proc->makeLabel();
+	OpdID cond = myCond->flatten(proc);
+	proc->addQuad(IfzQuad(cond, after));
+	for (auto stmt : *myBody){
+		stmt->to3AC(proc);
+	}
+	addLabeledNop(proc, after);
 }
 
 void IfElseStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	LabelID elseLbl = proc->makeLabel();
+	LabelID after = proc->makeLabel();
+	OpdID cond = myCond->flatten(proc);
+	proc->addQuad(IfzQuad(cond, elseLbl));
+	for (auto stmt : *myBodyTrue){
+		stmt->to3AC(proc);
+	}
+	proc->addQuad(GotoQuad(after));
+	addLabeledNop(proc, elseLbl);
+	for (auto stmt : *myBodyFalse){
+		stmt->to3AC(proc);
+	}
+	addLabeledNop(proc, after);
 }
 
 void WhileStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	LabelID head = proc->makeLabel();
+	LabelID after = proc->makeLabel();
+	addLabeledNop(proc, head);
+	OpdID cond = myCond->flatten(proc);
+	proc->addQuad(IfzQuad(cond, after));
+	for (auto stmt : *myBody){
+		stmt->to3AC(proc);
+	}
+	proc->addQuad(GotoQuad(head));
+	addLabeledNop(proc, after);
 }
 
 void CallStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	//Any return value is simply ignored
+	myCallExp->flatten(proc);
 }
 
 void ReturnStmtNode::to3AC(Procedure * proc){
-	TODO(Implement me)
+	if (myExp != nullptr){
+		proc->addQuad(SetRetQuad(myExp->flatten(proc)));
+	}
+	proc->addQuad(GotoQuad(proc->getLeaveLabel()));
 }
 
 void VarDeclNode::to3AC(Procedure * proc){
 	SemSymbol * sym = ID()->getSymbol();
 	assert(sym != nullptr);
+	if (sym->getDataType()->asRecord()){
+		proc->getProg()->declareRecord(sym, proc);
+		return;
+	}
 	proc->gatherLocal(sym);
 }
 
 void VarDeclNode::to3AC(IRProgram * prog){
 	SemSymbol * sym = ID()->getSymbol();
 	assert(sym != nullptr);
+	if (sym->getDataType()->asRecord()){
+		prog->declareRecord(sym, nullptr);
+		return;
+	}
 	prog->gatherGlobal(sym);
 }
 
-Opd * IndexNode::flatten(Procedure * proc){
-	TODO(Implement me)
+//A field is a variable of its own (see 
+// IRProgram::declareRecord), so it needs no address
+OpdID IndexNode::flatten(Procedure * proc){
+	SemSymbol * base = myBase->getSymbol();
+	assert(base != nullptr);
+	SemSymbol * field = proc->getProg()->fieldSym(base, myIdx->getName());
+	return proc->getSymOpd(field);
 }
 
 //We only get to this node if we are in a stmt
 // context (DeclNodes protect descent) 
-Opd * IDNode::flatten(Procedure * proc){
-	TODO(Implement me)
+OpdID IDNode::flatten(Procedure * proc){
+	assert(mySymbol != nullptr);
+	if (mySymbol->getDataType()->asRecord()){
+		proc->getProg()->errRecordValue(pos());
+		return proc->makeLit(0, 8);
+	}
+	return proc->getSymOpd(mySymbol);
 }
 
 }
@@ -3,121 +3,261 @@
 
 namespace cshanty{
 
-Procedure::Procedure(IRProgram * prog, std::string name)
-: myProg(prog), myName(name){
+Procedure::Procedure(IRProgram * prog, Ident name)
+: enter(EnterQuad()), leave(LeaveQuad()), myProg(prog), myName(name){
 	maxTmp = 0;
-	enter = new EnterQuad(this);
-	leave = new LeaveQuad(this);
-	bodyQuads = new std::list<Quad *>();
-	if (myName.compare("main") == 0){
-		enter->addLabel(new Label("main"));
-	} else {
-		enter->addLabel(new Label("fun_" + myName));
-	}
+	enter.addLabel(ENTRY_LABEL);
 	leaveLabel = myProg->makeLabel();
-	leave->addLabel(leaveLabel);
+	leave.addLabel(leaveLabel);
 }
 
 std::string Procedure::getName(){
-	return myName;
+	return myName.str();
 }
 
-Label * Procedure::getLeaveLabel(){
+LabelID Procedure::getLeaveLabel(){
 	return leaveLabel;
 }
 
 IRProgram * Procedure::getProg(){ return myProg; }
 
-std::string Procedure::toString(bool verbose){
-	std::string res = "";
-
-	res += "[BEGIN " + this->getName() + " LOCALS]\n";
-	for (const auto formal : this->formals){
-		res += formal->getName() + " (formal arg of " 
-			+ std::to_string(formal->getWidth()) + ")\n";
-			+ " bytes)\n";
+void Procedure::emit(std::ostream& out, bool verbose){
+	out << "[BEGIN " << this->getName() << " LOCALS]\n";
+	for (OpdID formal : this->formals){
+		const Opd& opd = getOpd(formal);
+		opd.writeLoc(out);
+		out << " (formal arg of " << opd.getWidth() << ")\n";
 	}
 
-	for (auto local : this->locals){
-		res += local.second->getName() + " (local var of "
-			+ std::to_string(local.second->getWidth())
-			+ " bytes)\n";
+	for (OpdID local : this->locals){
+		const Opd& opd = getOpd(local);
+		opd.writeLoc(out);
+		out << " (local var of " << opd.getWidth() << " bytes)\n";
 	}
 
-	for (auto tmp : temps){
-		res += tmp->locString() + " (tmp var of "
-			+ std::to_string(tmp->getWidth())
-			+ " bytes)\n";
+	for (OpdID tmp : temps){
+		const Opd& opd = getOpd(tmp);
+		opd.writeLoc(out);
+		out << " (tmp var of " << opd.getWidth() << " bytes)\n";
 	}
-	for (auto addrOpd : this->addrOpds){
-		res += addrOpd->locString() + " (addr opd of "
-			+ std::to_string(addrOpd->getWidth())
-			+ " bytes)\n";
+	for (OpdID addrOpd : this->addrOpds){
+		const Opd& opd = getOpd(addrOpd);
+		opd.writeLoc(out);
+		out << " (addr opd of " << opd.getWidth() << " bytes)\n";
 	}
-	res += "[END " + this->getName() + " LOCALS]\n";
+	out << "[END " << this->getName() << " LOCALS]\n";
 
-	res += enter->toString(verbose) + "\n";
-	for (auto quad : *bodyQuads){
-		res += quad->toString(verbose) + "\n";
+	enter.emit(out, this);
+	out.put('\n');
+	for (size_t i = 0; i < body.size(); i++){
+		body[i].emit(out, this);
+		if (verbose){
+			const std::string * comment = getComment(i);
+			if (comment != nullptr){ out << "  #" << *comment; }
+		}
+		out.put('\n');
 	}
-	res += leave->toString(verbose) + "\n";
-	return res;
+	leave.emit(out, this);
+	out.put('\n');
 }
 
-Label * Procedure::makeLabel(){
+LabelID Procedure::makeLabel(){
 	return myProg->makeLabel();
 }
 
-void Procedure::addQuad(Quad * quad){
-	bodyQuads->push_back(quad);
+size_t Procedure::addQuad(const Quad& quad){
+	body.push_back(quad);
+	return body.size() - 1;
 }
 
-Quad * Procedure::popQuad(){
-	Quad * last = bodyQuads->back();
-	bodyQuads->pop_back();
+Quad Procedure::popQuad(){
+	if (body.empty()){
+		throw new InternalError("Pop from an empty procedure");
+	}
+	Quad last = body.back();
+	body.pop_back();
+	comments.erase(body.size());
 	return last;
 }
 
-void Procedure::gatherLocal(SemSymbol * sym){
-	size_t width = Opd::width(sym->getDataType());
-	locals[sym] = new SymOpd(sym, width);
+void Procedure::replaceQuad(size_t idx, Quad quad){
+	quad.addLabel(body[idx].getLabel());
+	body[idx] = quad;
 }
 
-void Procedure::gatherFormal(SemSymbol * sym){
-	size_t width = Opd::width(sym->getDataType());
-	formals.push_back(new SymOpd(sym, width));
+void Procedure::removeQuads(const std::vector<bool>& dead){
+	std::set<LabelID> targets;
+	for (size_t i = 0; i < body.size(); i++){
+		QuadOp op = body[i].getOp();
+		if (!dead[i] && (op == QuadOp::GOTO || op == QuadOp::IFZ)){
+			targets.insert(body[i].getTarget());
+		}
+	}
+
+	std::map<size_t, std::string> kept;
+	size_t next = 0;
+	for (size_t i = 0; i < body.size(); i++){
+		Quad quad = body[i];
+		if (dead[i]){
+			if (targets.count(quad.getLabel()) == 0){ continue; }
+			quad = NopQuad();
+			quad.addLabel(body[i].getLabel());
+		} else {
+			auto comment = comments.find(i);
+			if (comment != comments.end()){
+				kept[next] = comment->second;
+			}
+		}
+		body[next++] = quad;
+	}
+	body.erase(body.begin() + static_cast<std::ptrdiff_t>(next), body.end());
+	comments.swap(kept);
+}
+
+void Procedure::insertQuads(
+	const std::vector<std::pair<size_t, Quad>>& inserts){
+	if (inserts.empty()){ return; }
+	//Fill in from the back, so each quad moves once
+	size_t oldSize = body.size();
+	body.resize(oldSize + inserts.size(), NopQuad());
+	std::map<size_t, std::string> moved;
+	size_t to = body.size();
+	size_t from = oldSize;
+	for (size_t k = inserts.size(); k-- > 0; ){
+		size_t idx = inserts[k].first;
+		while (from > idx){
+			from--;
+			to--;
+			body[to] = body[from];
+			auto comment = comments.find(from);
+			if (comment != comments.end()){ moved[to] = comment->second; }
+		}
+		to--;
+		body[to] = inserts[k].second;
+	}
+	for (auto& comment : comments){
+		if (comment.first < from){ moved[comment.first] = comment.second; }
+	}
+	comments.swap(moved);
 }
 
-SymOpd * Procedure::getSymOpd(SemSymbol * sym){
-	for(auto formalSeek : formals){
-		if (formalSeek->getSym() == sym){
-			return formalSeek;
+size_t Procedure::dropUnusedTemps(){
+	std::vector<bool> used(opds.size(), false);
+	for (const Quad& quad : body){
+		for (OpdID opd : {quad.getDst(), quad.getSrc1(), quad.getSrc2()}){
+			if (opd != NO_OPD){ used[opd] = true; }
 		}
 	}
+	size_t before = temps.size();
+	temps.erase(std::remove_if(temps.begin(), temps.end(),
+		[&](OpdID tmp){ return !used[tmp]; }), temps.end());
+	return before - temps.size();
+}
 
-	auto localFound = locals.find(sym);
-	if (localFound != locals.end()){
-		return localFound->second;
+void Procedure::setComment(size_t quadIdx, std::string comment){
+	if (comment.empty()){
+		comments.erase(quadIdx);
+	} else {
+		comments[quadIdx] = comment;
 	}
-	
-	return this->getProg()->getGlobal(sym);
 }
 
-AuxOpd * Procedure::makeTmp(size_t width){
-	std::string name = "varTmp";
-	name += std::to_string(maxTmp++);
-	AuxOpd * res = new AuxOpd(name, width);
-	temps.push_back(res);
+const std::string * Procedure::getComment(size_t quadIdx) const{
+	auto found = comments.find(quadIdx);
+	if (found == comments.end()){ return nullptr; }
+	return &found->second;
+}
+
+OpdID Procedure::addOpd(const Opd& opd){
+	if (opds.size() >= NO_OPD){
+		throw new InternalError("Too many operands in one procedure");
+	}
+	opds.push_back(opd);
+	return static_cast<OpdID>(opds.size() - 1);
+}
+
+void Procedure::gatherLocal(SemSymbol * sym){
+	locals.push_back(getSymOpd(sym));
+}
 
+void Procedure::gatherFormal(SemSymbol * sym){
+	formals.push_back(getSymOpd(sym));
+}
+
+OpdID Procedure::getFormal(size_t idx){
+	return formals.at(idx);
+}
+
+OpdID Procedure::getSymOpd(SemSymbol * sym){
+	auto found = symOpds.find(sym);
+	if (found != symOpds.end()){
+		return found->second;
+	}
+	//Functions are named by address, so their operands are
+	// pointer-sized whatever their type
+	size_t width = 8;
+	if (sym->getKind() != FN){
+		width = Opd::width(sym->getDataType());
+	}
+	OpdID res = addOpd(Opd::sym(sym, width));
+	symOpds[sym] = res;
 	return res;
 }
 
-AddrOpd * Procedure::makeAddrOpd(size_t width){
-	std::string name = "addrTmp";
-	name += std::to_string(maxTmp++);
-	AddrOpd * res = new AddrOpd(name, width);
+OpdID Procedure::makeTmp(size_t width){
+	OpdID res = addOpd(Opd::numbered(OpdKind::TMP, maxTmp++, width));
+	temps.push_back(res);
+	return res;
+}
+
+OpdID Procedure::makeAddrOpd(size_t width){
+	OpdID res = addOpd(Opd::numbered(OpdKind::ADDR, maxTmp++, width));
 	addrOpds.push_back(res);
+	return res;
+}
+
+OpdID Procedure::makeVersion(OpdID base, uint32_t version){
+	OpdID res = addOpd(Opd::version(opds[base], version));
+	temps.push_back(res);
+	return res;
+}
+
+OpdID Procedure::getRegOpd(uint32_t reg){
+	if (reg >= regOpds.size()){ regOpds.resize(reg + 1, NO_OPD); }
+	if (regOpds[reg] == NO_OPD){
+		regOpds[reg] = addOpd(Opd::numbered(OpdKind::REG, reg, 8));
+	}
+	return regOpds[reg];
+}
+
+uint32_t Procedure::makePhi(size_t numArgs){
+	if (phiStart.empty()){ phiStart.push_back(0); }
+	phiArgs.resize(phiArgs.size() + numArgs, NO_OPD);
+	phiStart.push_back(static_cast<uint32_t>(phiArgs.size()));
+	return static_cast<uint32_t>(phiStart.size() - 2);
+}
+
+void Procedure::clearPhis(){
+	phiArgs.clear();
+	phiStart.clear();
+}
 
+OpdID Procedure::makeLit(int64_t val, size_t width){
+	//Reuse the operand for this value unless it was made at
+	// a different width
+	auto found = litOpds.find(val);
+	if (found != litOpds.end() 
+	  && opds[found->second].getWidth() == width){
+		return found->second;
+	}
+	OpdID res = addOpd(Opd::lit(val, width));
+	litOpds[val] = res;
 	return res;
 }
+
+OpdID Procedure::makeString(std::string val){
+	uint32_t num = myProg->makeString(val);
+	return addOpd(Opd::numbered(OpdKind::STR, num, 1));
+}
+
 }
@@ -4,7 +4,7 @@
 
 namespace cshanty {
 
-Procedure * IRProgram::makeProc(std::string name){
+Procedure * IRProgram::makeProc(Ident name){
 	Procedure * proc = new Procedure(this, name);
 	procs->push_back(proc);
 	return proc;
@@ -22,57 +22,90 @@ size_t IRProgram::opWidth(ASTNode * node){
 	return Opd::width(nodeType(node));
 }
 
-Label * IRProgram::makeLabel(){
-	Label * label = new Label("lbl_" + std::to_string(max_label++));
-	return label;
+LabelID IRProgram::makeLabel(){
+	return max_label++;
 }
 
-SymOpd * IRProgram::getGlobal(SemSymbol * sym){
-	if (globals.find(sym) != globals.end()){
-		return globals[sym];
-	} 
-	return nullptr;
+bool IRProgram::isGlobal(SemSymbol * sym){
+	return globalSet.count(sym) > 0;
 }
 
 void IRProgram::gatherGlobal(SemSymbol * sym){
-	size_t width = Opd::width(sym->getDataType());
-	SymOpd * res = new SymOpd(sym, width);
-	globals[sym] = res;
+	if (globalSet.insert(sym).second){
+		globals.push_back(sym);
+	}
 }
 
-Opd * IRProgram::makeString(std::string val){
-	std::string name = "str_" + std::to_string(str_idx++);
-	AddrOpd * opd = new AddrOpd(name, 1);
-	strings[opd] = val;
-	return opd;
+void IRProgram::declareRecord(SemSymbol * base, Procedure * proc){
+	const RecordType * rec = base->getDataType()->asRecord();
+	assert(rec != nullptr);
+	HashMap<Ident, SemSymbol *>& fields = recordFields[base];
+	for (Ident field : rec->getFieldNames()){
+		Ident name = fieldNames.intern(base->getName() + "." + field.str());
+		fieldSyms.emplace_back(name, rec->getField(field));
+		SemSymbol * sym = &fieldSyms.back();
+		fields[field] = sym;
+		if (proc == nullptr){
+			gatherGlobal(sym);
+		} else {
+			proc->gatherLocal(sym);
+		}
+	}
 }
 
-std::string IRProgram::toString(bool verbose){
-	std::string res = "";
-	res += "[BEGIN GLOBALS]\n";
-	for (auto entry : globals){
-		res += entry.second->getName() + "\n"; 
-	}
-	for (auto entry : strings){
-		res += entry.first->locString();
-		res += " " + entry.second; 
-		res += "\n";
+SemSymbol * IRProgram::fieldSym(SemSymbol * base, Ident field){
+	auto fields = recordFields.find(base);
+	assert(fields != recordFields.end());
+	auto found = fields->second.find(field);
+	assert(found != fields->second.end());
+	return found->second;
+}
+
+void IRProgram::errRecordValue(Position pos){
+	hasError = true;
+	Report::fatal(pos, "Records can only be used field by field");
+}
+
+uint32_t IRProgram::makeString(std::string val){
+	auto found = stringIdx.find(val);
+	if (found != stringIdx.end()){
+		return found->second;
 	}
+	uint32_t num = static_cast<uint32_t>(strings.size());
+	strings.push_back(val);
+	stringIdx[val] = num;
+	return num;
+}
 
-	res += "[END GLOBALS]\n";
-	
-	for (Procedure * proc : *procs){
-		res += proc->toString(verbose);
+std::string IRProgram::stringValue(uint32_t num) const{
+	const std::string& lit = strings[num];
+	std::string res;
+	for (size_t i = 1; i + 1 < lit.length(); i++){
+		char c = lit[i];
+		if (c == '\\' && i + 2 < lit.length()){
+			c = lit[++i];
+			if (c == 'n'){ c = '\n'; }
+			else if (c == 't'){ c = '\t'; }
+		}
+		res.push_back(c);
 	}
 	return res;
 }
 
-std::set<Opd *> IRProgram::globalSyms(){
-	std::set<Opd *> result;
-	for (auto gItr : globals){
-		result.insert(gItr.second);
+void IRProgram::emit(std::ostream& out, bool verbose){
+	out << "[BEGIN GLOBALS]\n";
+	for (SemSymbol * global : globals){
+		out << global->getName() << "\n"; 
+	}
+	for (size_t i = 0; i < strings.size(); i++){
+		out << "str_" << i << " " << strings[i] << "\n";
+	}
+
+	out << "[END GLOBALS]\n";
+	
+	for (Procedure * proc : *procs){
+		proc->emit(out, verbose);
 	}
-	return result;
 }
 
 }
@@ -1,225 +1,261 @@
+#include <sstream>
 #include "3ac.hpp"
 
 namespace cshanty{
 
-
-Quad::Quad() : myComment(""){
-}
-
-void Quad::addLabel(Label * label){
-	if (label != nullptr){
-		labels.push_back(label);
+//Format a number by hand to avoid a temporary string
+static size_t writeNum(std::ostream& out, size_t num){
+	char digits[24];
+	size_t len = 0;
+	do {
+		digits[len++] = static_cast<char>('0' + num % 10);
+		num /= 10;
+	} while (num > 0);
+	for (size_t i = len; i > 0; i--){
+		out.put(digits[i - 1]);
 	}
+	return len;
 }
 
-void Quad::setComment(std::string commentIn){
-	this->myComment = commentIn;
-}
-
-std::string Quad::commentStr(){
-	if (myComment.length() > 0){
-		return "  #" + myComment;
+void Opd::writeLoc(std::ostream& out) const{
+	switch (myKind){
+	case OpdKind::SYM:
+		out << mySym->getName();
+		break;
+	case OpdKind::TMP:
+		out << "varTmp";
+		writeNum(out, myNum);
+		break;
+	case OpdKind::ADDR:
+		out << "addrTmp";
+		writeNum(out, myNum);
+		break;
+	case OpdKind::STR:
+		out << "str_";
+		writeNum(out, myNum);
+		return;
+	case OpdKind::REG:
+		out << "r";
+		writeNum(out, myNum);
+		return;
+	case OpdKind::LIT:
+		throw new InternalError("Tried to get location of a constant");
+	default:
+		throw new InternalError("Unknown operand kind");
+	}
+	if (getVersion() != 0){
+		out.put('.');
+		writeNum(out, getVersion());
 	}
-	return "";
 }
 
-std::string Quad::toString(bool verbose){
-	auto res = std::string("");
-
-	auto first = true;
-
-	size_t labelSpace = 12;
-	for (auto label : labels){
-		if (first){ first = false; }
-		else { res += ","; }
-
-		res += label->getName();
+void Opd::writeVal(std::ostream& out) const{
+	if (myKind == OpdKind::LIT){
+		out << myValue;
+		return;
 	}
-	if (!first){ res += ": "; }
-	else { res += "  "; }
-	size_t spaces;
-	if (res.length() > labelSpace){ spaces = 0; }
-	else { spaces = labelSpace - res.length(); }
-	for (size_t i = 0; i < spaces; i++){
-		res += " ";
+	//A register holds its value; it isn't a place in memory
+	if (myKind == OpdKind::REG){
+		writeLoc(out);
+		return;
 	}
-
-	res += this->repr();
-	if (verbose){
-		res += commentStr();
-	}
-
-	return res;
+	out.put('[');
+	writeLoc(out);
+	out.put(']');
 }
 
-CallQuad::CallQuad(SemSymbol * calleeIn) : callee(calleeIn){ }
-
-std::string CallQuad::repr(){
-	return "call " + callee->getName();
+std::string Opd::valString() const{
+	std::ostringstream res;
+	writeVal(res);
+	return res.str();
 }
 
-EnterQuad::EnterQuad(Procedure * procIn)
-: Quad(), myProc(procIn) { }
-
-std::string EnterQuad::repr(){
-	return "enter " + myProc->getName();
-}
-
-LeaveQuad::LeaveQuad(Procedure * procIn)
-: Quad(), myProc(procIn) { }
-
-std::string LeaveQuad::repr(){
-	return "leave " + myProc->getName();
+std::string Opd::locString() const{
+	std::ostringstream res;
+	writeLoc(res);
+	return res.str();
 }
 
-std::string AssignQuad::repr(){
-	return dst->valString() + " := " + src->valString();
-	
-}
+size_t Procedure::emitLabel(std::ostream& out, LabelID label){
+	if (label == ENTRY_LABEL){
+		if (myName.str() == "main"){
+			out << "main";
+			return 4;
+		}
+		out << "fun_" << myName;
+		return 4 + myName.str().length();
+	}
 
-AssignQuad::AssignQuad(Opd * dstIn, Opd * srcIn): dst(dstIn), src(srcIn){
-	assert(dstIn != nullptr);
-	assert(srcIn != nullptr);
+	out << "lbl_";
+	return 4 + writeNum(out, label);
 }
 
-BinOpQuad::BinOpQuad(Opd * dstIn, BinOp oprIn, Opd * src1In, Opd * src2In)
-: dst(dstIn), opr(oprIn), src1(src1In), src2(src2In){
-	assert(dstIn != nullptr);
-	assert(src1In != nullptr);
-	assert(src2In != nullptr);
-}
+void Quad::emit(std::ostream& out, Procedure * proc) const{
+	static const char padding[] = "            ";
+	const size_t labelSpace = sizeof(padding) - 1;
 
-std::string BinOpQuad::oprString(BinOp opr){
-	switch(opr){
-	case ADD64: return "ADD64";  
-	case SUB64: return "SUB64";  
-	case DIV64: return "DIV64";  
-	case MULT64: return "MULT64";  
-	case OR64: return "OR64";  
-	case AND64: return "AND64";  
-	case EQ64: return "EQ64";  
-	case NEQ64: return "NEQ64";  
-	case LT64: return "LT64";  
-	case GT64: return "GT64";  
-	case LTE64: return "LTE64";  
-	case GTE64: return "GTE64";  
-		
-	} 
-
-}
+	size_t width = 0;
+	if (label != NO_LABEL){
+		width += proc->emitLabel(out, label);
+		out << ": ";
+	} else {
+		out << "  ";
+	}
+	width += 2;
+	if (width < labelSpace){
+		out.write(padding, static_cast<std::streamsize>(labelSpace - width));
+	}
 
-std::string BinOpQuad::repr(){
-	std::string opString;
-	return dst->valString()
-		+ " := " 
-		+ src1->valString()
-		+ " " + BinOpQuad::oprString(opr) + " "
-		+ src2->valString();
+	this->repr(out, proc);
 }
 
-UnaryOpQuad::UnaryOpQuad(Opd * dstIn, UnaryOp opIn, Opd * srcIn)
-: dst(dstIn), op(opIn), src(srcIn) { 
-	assert(dstIn != nullptr);
-	assert(srcIn != nullptr);
+std::string Quad::toString(Procedure * proc) const{
+	std::ostringstream res;
+	emit(res, proc);
+	return res.str();
 }
 
-std::string UnaryOpQuad::repr(){
-	std::string opString;
+bool Quad::hasSideEffects() const{
 	switch (op){
-	case NEG64:
-		opString = "NEG64 ";
-		break;
-	case NOT8:
-		opString = "NOT8 ";
+	case QuadOp::ASSIGN:
+	case QuadOp::BINOP:
+	case QuadOp::UNARYOP:
+	case QuadOp::INDEX:
+	case QuadOp::NOP:
+	case QuadOp::GETARG:
+	case QuadOp::GETRET:
+	case QuadOp::PHI:
+		return false;
+	case QuadOp::GOTO:
+	case QuadOp::IFZ:
+	case QuadOp::REPORT:
+	case QuadOp::RECEIVE:
+	case QuadOp::CALL:
+	case QuadOp::ENTER:
+	case QuadOp::LEAVE:
+	case QuadOp::SETARG:
+	case QuadOp::SETRET:
+		return true;
 	}
-	return dst->valString() + " := " 
-		+ opString
-		+ src->valString();
-}
-
-ReportQuad::ReportQuad(Opd * opd, const DataType * type) 
-: myArg(opd), myType(type){ }
-
-std::string ReportQuad::repr(){
-	return "REPORT " + myArg->valString();
-}
-
-ReceiveQuad::ReceiveQuad(Opd * opd, const DataType * type)
-: myArg(opd), myType(type){ }
-
-std::string ReceiveQuad::repr(){
-	return "RECEIVE " + myArg->valString();
-}
-
-GotoQuad::GotoQuad(Label * tgtIn)
-: Quad(), tgt(tgtIn){ }
-
-std::string GotoQuad::repr(){
-	std::string res = "";
-	return "goto " + tgt->getName();
-}
-
-IfzQuad::IfzQuad(Opd * cndIn, Label * tgtIn) 
-: Quad(), cnd(cndIn), tgt(tgtIn){ }
-
-std::string IfzQuad::repr(){
-	std::string res = "IFZ ";
-	res += cnd->valString();
-	res += " GOTO ";
-	res += tgt->getName();
-	return res;
-}
-
-NopQuad::NopQuad()
-: Quad() { }
-
-std::string NopQuad::repr(){
-	return "nop";
-}
-
-GetRetQuad::GetRetQuad(Opd * opdIn)
-: Quad(), opd(opdIn) { }
-
-std::string GetRetQuad::repr(){
-	std::string res = "";
-	res += "getret " + opd->valString(); 
-	return res;
+	throw new InternalError("Unknown quad kind");
 }
 
-SetArgQuad::SetArgQuad(size_t indexIn, Opd * opdIn) 
-: index(indexIn), opd(opdIn){
-}
-
-std::string SetArgQuad::repr(){
-	std::string res = "";
-	res += "setarg " + std::to_string(index) + " " + opd->valString(); 
-	return res;
-}
-
-GetArgQuad::GetArgQuad(size_t indexIn, Opd * opdIn) 
-: index(indexIn), opd(opdIn){
-}
-
-std::string GetArgQuad::repr(){
-	std::string res = "";
-	res += "getarg " + std::to_string(index) + " " + opd->valString(); 
-	return res;
-}
-
-SetRetQuad::SetRetQuad(Opd * opdIn) 
-: opd(opdIn){
+const char * BinOpQuad::oprString(BinOp opr){
+	switch(opr){
+	case ADD64: return "ADD64";
+	case SUB64: return "SUB64";
+	case DIV64: return "DIV64";
+	case MULT64: return "MULT64";
+	case OR64: return "OR64";
+	case AND64: return "AND64";
+	case EQ64: return "EQ64";
+	case NEQ64: return "NEQ64";
+	case LT64: return "LT64";
+	case GT64: return "GT64";
+	case LTE64: return "LTE64";
+	case GTE64: return "GTE64";
+	}
+	throw new InternalError("Unknown binary operator");
 }
 
-std::string SetRetQuad::repr(){
-	std::string res = "";
-	res += "setret " + opd->valString(); 
-	return res;
+static const char * unaryString(UnaryOp op){
+	switch (op){
+	case NEG64: return "NEG64 ";
+	case NOT8: return "NOT8 ";
+	}
+	throw new InternalError("Unknown unary operator");
 }
 
-std::string IndexQuad::repr(){
-	std::string res = dst->locString() + " := "
-	+ src->locString() + " ADD64 " + off->valString();
-	return res;
+void Quad::repr(std::ostream& out, Procedure * proc) const{
+	switch (op){
+	case QuadOp::ASSIGN:
+		proc->getOpd(dst).writeVal(out);
+		out << " := ";
+		proc->getOpd(src1).writeVal(out);
+		return;
+	case QuadOp::BINOP:
+		proc->getOpd(dst).writeVal(out);
+		out << " := ";
+		proc->getOpd(src1).writeVal(out);
+		out << " " << BinOpQuad::oprString(getBinOp()) << " ";
+		proc->getOpd(src2).writeVal(out);
+		return;
+	case QuadOp::UNARYOP:
+		proc->getOpd(dst).writeVal(out);
+		out << " := " << unaryString(getUnaryOp());
+		proc->getOpd(src1).writeVal(out);
+		return;
+	case QuadOp::INDEX:
+		proc->getOpd(dst).writeLoc(out);
+		out << " := ";
+		proc->getOpd(src1).writeLoc(out);
+		out << " ADD64 ";
+		proc->getOpd(src2).writeVal(out);
+		return;
+	case QuadOp::GOTO:
+		out << "goto ";
+		proc->emitLabel(out, aux);
+		return;
+	case QuadOp::IFZ:
+		out << "IFZ ";
+		proc->getOpd(src1).writeVal(out);
+		out << " GOTO ";
+		proc->emitLabel(out, aux);
+		return;
+	case QuadOp::NOP:
+		out << "nop";
+		return;
+	case QuadOp::REPORT:
+		out << "REPORT ";
+		proc->getOpd(src1).writeVal(out);
+		return;
+	case QuadOp::RECEIVE:
+		out << "RECEIVE ";
+		proc->getOpd(dst).writeVal(out);
+		return;
+	case QuadOp::CALL:
+		out << "call ";
+		proc->getOpd(src1).writeLoc(out);
+		return;
+	case QuadOp::ENTER:
+		out << "enter " << proc->getName();
+		return;
+	case QuadOp::LEAVE:
+		out << "leave " << proc->getName();
+		return;
+	case QuadOp::SETARG:
+		out << "setarg " << aux << " ";
+		proc->getOpd(src1).writeVal(out);
+		return;
+	case QuadOp::GETARG:
+		out << "getarg " << aux << " ";
+		proc->getOpd(dst).writeVal(out);
+		return;
+	case QuadOp::SETRET:
+		out << "setret ";
+		proc->getOpd(src1).writeVal(out);
+		return;
+	case QuadOp::GETRET:
+		out << "getret ";
+		proc->getOpd(dst).writeVal(out);
+		return;
+	case QuadOp::PHI: {
+		proc->getOpd(dst).writeVal(out);
+		out << " := phi(";
+		OpdID * args = proc->getPhiArgs(aux);
+		for (size_t i = 0; i < proc->numPhiArgs(aux); i++){
+			if (i > 0){ out << ", "; }
+			if (args[i] == NO_OPD){
+				out << "?";
+			} else {
+				proc->getOpd(args[i]).writeVal(out);
+			}
+		}
+		out << ")";
+		return;
+	}
+	}
+	throw new InternalError("Unknown quad kind");
 }
 
 }
@@ -0,0 +1,64 @@
+#include <cstdlib>
+#include <stdint.h>
+#include "arena.hpp"
+
+namespace cshanty{
+
+Arena::Arena()
+: blocks(nullptr), cursor(nullptr), limit(nullptr),
+  finalizers(nullptr), objects(0), used(0), reserved(0){
+}
+
+Arena::~Arena(){
+	//Finalizers were pushed on the front of the chain, so
+	// objects are destroyed in the reverse order of creation
+	for (Finalizer * f = finalizers; f != nullptr; f = f->next){
+		f->fn(f->obj);
+	}
+	while (blocks != nullptr){
+		Block * prev = blocks->prev;
+		std::free(blocks);
+		blocks = prev;
+	}
+}
+
+void Arena::newBlock(size_t minSize){
+	size_t size = BLOCK_SIZE;
+	size_t needed = minSize + sizeof(Block) + alignof(std::max_align_t);
+	if (needed > size){ size = needed; }
+
+	Block * block = static_cast<Block *>(std::malloc(size));
+	if (block == nullptr){ throw std::bad_alloc(); }
+	block->prev = blocks;
+	block->size = size;
+	blocks = block;
+	reserved += size;
+
+	cursor = reinterpret_cast<char *>(block + 1);
+	limit = reinterpret_cast<char *>(block) + size;
+}
+
+void * Arena::allocate(size_t size, size_t align){
+	uintptr_t addr = reinterpret_cast<uintptr_t>(cursor);
+	uintptr_t aligned = (addr + align - 1) & ~(uintptr_t(align) - 1);
+	if (cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(limit)){
+		newBlock(size + align);
+		addr = reinterpret_cast<uintptr_t>(cursor);
+		aligned = (addr + align - 1) & ~(uintptr_t(align) - 1);
+	}
+	char * res = reinterpret_cast<char *>(aligned);
+	used += static_cast<size_t>((res + size) - cursor);
+	cursor = res + size;
+	return res;
+}
+
+void Arena::addFinalizer(void * obj, void (*fn)(void *)){
+	void * mem = allocate(sizeof(Finalizer), alignof(Finalizer));
+	Finalizer * f = new (mem) Finalizer();
+	f->fn = fn;
+	f->obj = obj;
+	f->next = finalizers;
+	finalizers = f;
+}
+
+}
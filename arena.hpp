@@ -0,0 +1,123 @@
+#ifndef CSHANTY_ARENA_HPP
+#define CSHANTY_ARENA_HPP
+
+#include <cstddef>
+#include <list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cshanty{
+
+//A per-compilation bump allocator. The AST and the tokens
+// it is built from are all carved out of a few large
+// blocks owned by the arena, and are released together
+// when the arena is destroyed (i.e. when the compilation
+// that built them ends). Nothing made by the arena should
+// be deleted individually.
+class Arena{
+public:
+	Arena();
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	//Get raw, suitably aligned storage from the current block
+	void * allocate(size_t size, size_t align);
+
+	//Construct a T in arena storage. If T needs its
+	// destructor run (for example, because it owns a
+	// std::string), the arena remembers to run it when
+	// the arena is torn down.
+	template <typename T, typename... Args>
+	T * make(Args&&... args){
+		void * mem = allocate(sizeof(T), alignof(T));
+		T * obj = new (mem) T(std::forward<Args>(args)...);
+		objects++;
+		if (!std::is_trivially_destructible<T>::value){
+			addFinalizer(obj, &destroy<T>);
+		}
+		return obj;
+	}
+
+	//Number of objects constructed through make
+	size_t objectCount() const { return objects; }
+	//Bytes handed out by allocate, including padding
+	size_t bytesUsed() const { return used; }
+	//Bytes obtained from the system for blocks
+	size_t bytesReserved() const { return reserved; }
+private:
+	struct Block{
+		Block * prev;
+		size_t size;
+	};
+	struct Finalizer{
+		void (*fn)(void *);
+		void * obj;
+		Finalizer * next;
+	};
+
+	template <typename T>
+	static void destroy(void * obj){
+		static_cast<T *>(obj)->~T();
+	}
+	void addFinalizer(void * obj, void (*fn)(void *));
+	void newBlock(size_t minSize);
+
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	Block * blocks;
+	char * cursor;
+	char * limit;
+	Finalizer * finalizers;
+	size_t objects;
+	size_t used;
+	size_t reserved;
+};
+
+//Standard allocator interface over an Arena, so that
+// containers can keep their nodes in arena storage.
+// Deallocation is a no-op: the memory is reclaimed when
+// the arena goes away.
+template <typename T>
+class ArenaAllocator{
+public:
+	typedef T value_type;
+
+	ArenaAllocator(Arena * arenaIn) : myArena(arenaIn){ }
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other)
+	: myArena(other.arena()){ }
+
+	T * allocate(size_t n){
+		return static_cast<T *>(
+			myArena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T *, size_t){ }
+	Arena * arena() const { return myArena; }
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const{
+		return myArena == other.arena();
+	}
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const{
+		return myArena != other.arena();
+	}
+private:
+	Arena * myArena;
+};
+
+//The list type used for every sequence in the AST. Both
+// the list header and its nodes live in the arena.
+template <typename T>
+using NodeList = std::list<T, ArenaAllocator<T>>;
+
+template <typename T>
+NodeList<T> * makeNodeList(Arena& arena){
+	return arena.make<NodeList<T>>(ArenaAllocator<T>(&arena));
+}
+
+}
+
+#endif
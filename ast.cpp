@@ -1,9 +1,13 @@
 #include "ast.hpp"
 
-cshanty::ProgramNode::ProgramNode(std::list<DeclNode *> * globalsIn)
-: ASTNode(new Position(0,0,0,0)), myGlobals(globalsIn){
+thread_local uint32_t cshanty::ASTNode::nextID = 0;
+
+//The root is built last, so every node in the tree has
+// been numbered by now
+cshanty::ProgramNode::ProgramNode(Position p, NodeList<DeclNode *> * globalsIn)
+: ASTNode(p), myGlobals(globalsIn), myNodeCount(ASTNode::idsIssued()){
 	if (!globalsIn->empty()){
-		myPos->expand(
+		myPos.expand(
 			myGlobals->front()->pos(),
 			myGlobals->back()->pos()
 		);
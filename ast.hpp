@@ -5,6 +5,7 @@
 #include <sstream>
 #include <string.h>
 #include <list>
+#include "arena.hpp"
 #include "tokens.hpp"
 #include "types.hpp"
 #include "3ac.hpp"
@@ -13,8 +14,6 @@ namespace cshanty {
 
 class TypeAnalysis;
 
-class Opd;
-
 class SymbolTable;
 class SemSymbol;
 
@@ -30,65 +29,79 @@ class IDNode;
 
 class ASTNode{
 public:
-	ASTNode(Position * pos) : myPos(pos){ }
+	ASTNode(Position pos) : myPos(pos), myID(nextID++){ }
 	virtual void unparse(std::ostream&, int) = 0;
-	Position * pos() { return myPos; };
-	std::string posStr(){ return pos()->span(); }
+	Position pos() { return myPos; };
+	std::string posStr(){ return pos().span(); }
 	virtual bool nameAnalysis(SymbolTable *) = 0;
+	//Nodes are numbered densely, in the order they are
+	// built, from 0 for each parse. Later passes use the
+	// id to keep per-node data in flat arrays. Numbering is
+	// per thread, so parses on different threads don't 
+	// interfere.
+	uint32_t id() const { return myID; }
+	static void resetIDs(){ nextID = 0; }
+	static uint32_t idsIssued(){ return nextID; }
 protected:
-	Position * myPos = nullptr;
+	Position myPos;
+private:
+	uint32_t myID;
+	static thread_local uint32_t nextID;
 };
 
 class ProgramNode : public ASTNode{
 public:
-	ProgramNode(std::list<DeclNode *> * globalsIn);
+	ProgramNode(Position p, NodeList<DeclNode *> * globalsIn);
 	void unparse(std::ostream&, int) override;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
 	IRProgram * to3AC(TypeAnalysis * ta);
+	//The number of node ids used by this program's AST
+	uint32_t nodeCount() const { return myNodeCount; }
 private:
-	std::list<DeclNode *> * myGlobals;
+	NodeList<DeclNode *> * myGlobals;
+	uint32_t myNodeCount;
 };
 
 class ExpNode : public ASTNode{
 protected:
-	ExpNode(Position * p) : ASTNode(p){ }
+	ExpNode(Position p) : ASTNode(p){ }
 public:
 	virtual void unparseNested(std::ostream& out);
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) = 0;
-	virtual Opd * flatten(Procedure * proc) = 0;
+	virtual OpdID flatten(Procedure * proc) = 0;
 };
 
 class LValNode : public ExpNode{
 public:
-	LValNode(Position * p) : ExpNode(p){}
+	LValNode(Position p) : ExpNode(p){}
 	void unparse(std::ostream& out, int indent) override = 0;
 	void unparseNested(std::ostream& out) override;
 	bool nameAnalysis(SymbolTable * symTab) override { return false; }
 	virtual void typeAnalysis(TypeAnalysis *) override {; } 
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 };
 
 class IDNode : public LValNode{
 public:
-	IDNode(Position * p, std::string nameIn)
+	IDNode(Position p, Ident nameIn)
 	: LValNode(p), name(nameIn), mySymbol(nullptr){}
-	std::string getName(){ return name; }
+	Ident getName(){ return name; }
 	void unparse(std::ostream& out, int indent) override;
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol() const { return mySymbol; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 private:
-	std::string name;
+	Ident name;
 	SemSymbol * mySymbol;
 };
 
 class IndexNode : public LValNode{
 public:
-	IndexNode(Position * p, IDNode * base, IDNode * idx)
+	IndexNode(Position p, IDNode * base, IDNode * idx)
 	: LValNode(p), myBase(base), myIdx(idx){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
@@ -96,7 +109,7 @@ public:
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 private:
 	IDNode * myBase;
 	IDNode * myIdx;
@@ -104,7 +117,7 @@ private:
 
 class TypeNode : public ASTNode{
 public:
-	TypeNode(Position * p) : ASTNode(p){ }
+	TypeNode(Position p) : ASTNode(p){ }
 	void unparse(std::ostream&, int) override = 0;
 	virtual const DataType * getType() = 0;
 	virtual bool nameAnalysis(SymbolTable *) override;
@@ -113,7 +126,7 @@ public:
 
 class RecordTypeNode : public TypeNode{
 public:
-	RecordTypeNode(Position * p, IDNode * IDin)
+	RecordTypeNode(Position p, IDNode * IDin)
 	:TypeNode(p), myID(IDin) { }
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override { return myType; }
@@ -126,7 +139,7 @@ private:
 
 class StmtNode : public ASTNode{
 public:
-	StmtNode(Position * p) : ASTNode(p){ }
+	StmtNode(Position p) : ASTNode(p){ }
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) = 0;
 	virtual void to3AC(Procedure * proc) = 0;
@@ -134,7 +147,7 @@ public:
 
 class DeclNode : public StmtNode{
 public:
-	DeclNode(Position * p) : StmtNode(p){ }
+	DeclNode(Position p) : StmtNode(p){ }
 	void unparse(std::ostream& out, int indent) override =0;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
 	virtual void to3AC(IRProgram * prog) = 0;
@@ -143,7 +156,7 @@ public:
 
 class VarDeclNode : public DeclNode{
 public:
-	VarDeclNode(Position * p, TypeNode * typeIn, IDNode * IDIn)
+	VarDeclNode(Position p, TypeNode * typeIn, IDNode * IDIn)
 	: DeclNode(p), myType(typeIn), myID(IDIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	IDNode * ID(){ return myID; }
@@ -159,7 +172,7 @@ private:
 
 class RecordTypeDeclNode : public DeclNode{
 public:
-	RecordTypeDeclNode(Position *p, IDNode *id, std::list<VarDeclNode*> *body)
+	RecordTypeDeclNode(Position p, IDNode *id, NodeList<VarDeclNode *> *body)
 	: DeclNode(p), myID(id), myFields(body){ }
 	void unparse(std::ostream& out, int indent) override;
 	TypeNode * getTypeNode(){ return nullptr; }
@@ -169,12 +182,12 @@ public:
 	virtual void to3AC(IRProgram * prog) override;
 private:
 	IDNode * myID;
-	std::list<VarDeclNode *> * myFields;
+	NodeList<VarDeclNode *> * myFields;
 };
 
 class FormalDeclNode : public VarDeclNode{
 public:
-	FormalDeclNode(Position * p, TypeNode * type, IDNode * id) 
+	FormalDeclNode(Position p, TypeNode * type, IDNode * id) 
 	: VarDeclNode(p, type, id){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void to3AC(Procedure * proc) override;
@@ -183,15 +196,15 @@ public:
 
 class FnDeclNode : public DeclNode{
 public:
-	FnDeclNode(Position * p, 
+	FnDeclNode(Position p, 
 	  TypeNode * retTypeIn, IDNode * idIn,
-	  std::list<FormalDeclNode *> * formalsIn,
-	  std::list<StmtNode *> * bodyIn)
+	  NodeList<FormalDeclNode *> * formalsIn,
+	  NodeList<StmtNode *> * bodyIn)
 	: DeclNode(p), myRetType(retTypeIn), myID(idIn),
 	  myFormals(formalsIn), myBody(bodyIn){ 
 	}
 	IDNode * ID() const { return myID; }
-	std::list<FormalDeclNode *> * getFormals() const{
+	NodeList<FormalDeclNode *> * getFormals() const{
 		return myFormals;
 	}
 	void unparse(std::ostream& out, int indent) override;
@@ -205,13 +218,13 @@ public:
 private:
 	TypeNode * myRetType;
 	IDNode * myID;
-	std::list<FormalDeclNode *> * myFormals;
-	std::list<StmtNode *> * myBody;
+	NodeList<FormalDeclNode *> * myFormals;
+	NodeList<StmtNode *> * myBody;
 };
 
 class AssignStmtNode : public StmtNode{
 public:
-	AssignStmtNode(Position * p, AssignExpNode * expIn)
+	AssignStmtNode(Position p, AssignExpNode * expIn)
 	: StmtNode(p), myExp(expIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -223,7 +236,7 @@ private:
 
 class ReceiveStmtNode : public StmtNode{
 public:
-	ReceiveStmtNode(Position * p, LValNode * dstIn)
+	ReceiveStmtNode(Position p, LValNode * dstIn)
 	: StmtNode(p), myDst(dstIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -235,7 +248,7 @@ private:
 
 class ReportStmtNode : public StmtNode{
 public:
-	ReportStmtNode(Position * p, ExpNode * srcIn)
+	ReportStmtNode(Position p, ExpNode * srcIn)
 	: StmtNode(p), mySrc(srcIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -247,7 +260,7 @@ private:
 
 class PostDecStmtNode : public StmtNode{
 public:
-	PostDecStmtNode(Position * p, LValNode * lvalIn)
+	PostDecStmtNode(Position p, LValNode * lvalIn)
 	: StmtNode(p), myLVal(lvalIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
@@ -259,7 +272,7 @@ private:
 
 class PostIncStmtNode : public StmtNode{
 public:
-	PostIncStmtNode(Position * p, LValNode * lvalIn)
+	PostIncStmtNode(Position p, LValNode * lvalIn)
 	: StmtNode(p), myLVal(lvalIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
@@ -271,8 +284,8 @@ private:
 
 class IfStmtNode : public StmtNode{
 public:
-	IfStmtNode(Position * p, ExpNode * condIn,
-	  std::list<StmtNode *> * bodyIn)
+	IfStmtNode(Position p, ExpNode * condIn,
+	  NodeList<StmtNode *> * bodyIn)
 	: StmtNode(p), myCond(condIn), myBody(bodyIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -280,14 +293,14 @@ public:
 	virtual void to3AC(Procedure * prog) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	NodeList<StmtNode *> * myBody;
 };
 
 class IfElseStmtNode : public StmtNode{
 public:
-	IfElseStmtNode(Position * p, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyTrueIn,
-	  std::list<StmtNode *> * bodyFalseIn)
+	IfElseStmtNode(Position p, ExpNode * condIn, 
+	  NodeList<StmtNode *> * bodyTrueIn,
+	  NodeList<StmtNode *> * bodyFalseIn)
 	: StmtNode(p), myCond(condIn),
 	  myBodyTrue(bodyTrueIn), myBodyFalse(bodyFalseIn) { }
 	void unparse(std::ostream& out, int indent) override;
@@ -296,14 +309,14 @@ public:
 	virtual void to3AC(Procedure * prog) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBodyTrue;
-	std::list<StmtNode *> * myBodyFalse;
+	NodeList<StmtNode *> * myBodyTrue;
+	NodeList<StmtNode *> * myBodyFalse;
 };
 
 class WhileStmtNode : public StmtNode{
 public:
-	WhileStmtNode(Position * p, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyIn)
+	WhileStmtNode(Position p, ExpNode * condIn, 
+	  NodeList<StmtNode *> * bodyIn)
 	: StmtNode(p), myCond(condIn), myBody(bodyIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -311,12 +324,12 @@ public:
 	virtual void to3AC(Procedure * prog) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	NodeList<StmtNode *> * myBody;
 };
 
 class ReturnStmtNode : public StmtNode{
 public:
-	ReturnStmtNode(Position * p, ExpNode * exp)
+	ReturnStmtNode(Position p, ExpNode * exp)
 	: StmtNode(p), myExp(exp){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -328,8 +341,8 @@ private:
 
 class CallExpNode : public ExpNode{
 public:
-	CallExpNode(Position * p, IDNode * id,
-	  std::list<ExpNode *> * argsIn)
+	CallExpNode(Position p, IDNode * id,
+	  NodeList<ExpNode *> * argsIn)
 	: ExpNode(p), myID(id), myArgs(argsIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	void unparseNested(std::ostream& out) override;
@@ -337,19 +350,19 @@ public:
 	void typeAnalysis(TypeAnalysis *) override;
 	DataType * getRetType();
 
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 private:
 	IDNode * myID;
-	std::list<ExpNode *> * myArgs;
+	NodeList<ExpNode *> * myArgs;
 };
 
 class BinaryExpNode : public ExpNode{
 public:
-	BinaryExpNode(Position * p, ExpNode * lhs, ExpNode * rhs)
+	BinaryExpNode(Position p, ExpNode * lhs, ExpNode * rhs)
 	: ExpNode(p), myExp1(lhs), myExp2(rhs) { }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
-	virtual Opd * flatten(Procedure * prog) override = 0;
+	virtual OpdID flatten(Procedure * prog) override = 0;
 protected:
 	ExpNode * myExp1;
 	ExpNode * myExp2;
@@ -361,151 +374,151 @@ protected:
 
 class PlusNode : public BinaryExpNode{
 public:
-	PlusNode(Position * p, ExpNode * e1, ExpNode * e2)
+	PlusNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class MinusNode : public BinaryExpNode{
 public:
-	MinusNode(Position * p, ExpNode * e1, ExpNode * e2)
+	MinusNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class TimesNode : public BinaryExpNode{
 public:
-	TimesNode(Position * p, ExpNode * e1In, ExpNode * e2In)
+	TimesNode(Position p, ExpNode * e1In, ExpNode * e2In)
 	: BinaryExpNode(p, e1In, e2In){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class DivideNode : public BinaryExpNode{
 public:
-	DivideNode(Position * p, ExpNode * e1, ExpNode * e2)
+	DivideNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class AndNode : public BinaryExpNode{
 public:
-	AndNode(Position * p, ExpNode * e1, ExpNode * e2)
+	AndNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class OrNode : public BinaryExpNode{
 public:
-	OrNode(Position * p, ExpNode * e1, ExpNode * e2)
+	OrNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class EqualsNode : public BinaryExpNode{
 public:
-	EqualsNode(Position * p, ExpNode * e1, ExpNode * e2)
+	EqualsNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 	
 };
 
 class NotEqualsNode : public BinaryExpNode{
 public:
-	NotEqualsNode(Position * p, ExpNode * e1, ExpNode * e2)
+	NotEqualsNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 	
 };
 
 class LessNode : public BinaryExpNode{
 public:
-	LessNode(Position * p, ExpNode * e1, ExpNode * e2)
+	LessNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 };
 
 class LessEqNode : public BinaryExpNode{
 public:
-	LessEqNode(Position * pos, ExpNode * e1, ExpNode * e2)
+	LessEqNode(Position pos, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(pos, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class GreaterNode : public BinaryExpNode{
 public:
-	GreaterNode(Position * p, ExpNode * e1, ExpNode * e2)
+	GreaterNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 };
 
 class GreaterEqNode : public BinaryExpNode{
 public:
-	GreaterEqNode(Position * p, ExpNode * e1, ExpNode * e2)
+	GreaterEqNode(Position p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class UnaryExpNode : public ExpNode {
 public:
-	UnaryExpNode(Position * p, ExpNode * expIn) 
+	UnaryExpNode(Position p, ExpNode * expIn) 
 	: ExpNode(p){
 		this->myExp = expIn;
 	}
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
-	virtual Opd * flatten(Procedure * prog) override = 0;
+	virtual OpdID flatten(Procedure * prog) override = 0;
 protected:
 	ExpNode * myExp;
 };
 
 class NegNode : public UnaryExpNode{
 public:
-	NegNode(Position * p, ExpNode * exp)
+	NegNode(Position p, ExpNode * exp)
 	: UnaryExpNode(p, exp){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class NotNode : public UnaryExpNode{
 public:
-	NotNode(Position * p, ExpNode * exp)
+	NotNode(Position p, ExpNode * exp)
 	: UnaryExpNode(p, exp){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class VoidTypeNode : public TypeNode{
 public:
-	VoidTypeNode(Position * p) : TypeNode(p){}
+	VoidTypeNode(Position p) : TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType()override { 
 		return BasicType::VOID(); 
@@ -514,33 +527,33 @@ public:
 
 class IntTypeNode : public TypeNode{
 public:
-	IntTypeNode(Position * p): TypeNode(p){}
+	IntTypeNode(Position p): TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class BoolTypeNode : public TypeNode{
 public:
-	BoolTypeNode(Position * p): TypeNode(p) { }
+	BoolTypeNode(Position p): TypeNode(p) { }
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class StringTypeNode : public TypeNode{
 public:
-	StringTypeNode(Position * p): TypeNode(p) { }
+	StringTypeNode(Position p): TypeNode(p) { }
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class AssignExpNode : public ExpNode{
 public:
-	AssignExpNode(Position * p, LValNode * dstIn, ExpNode * srcIn)
+	AssignExpNode(Position p, LValNode * dstIn, ExpNode * srcIn)
 	: ExpNode(p), myDst(dstIn), mySrc(srcIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 private:
 	LValNode * myDst;
 	ExpNode * mySrc;
@@ -548,7 +561,7 @@ private:
 
 class IntLitNode : public ExpNode{
 public:
-	IntLitNode(Position * p, const int numIn)
+	IntLitNode(Position p, const int numIn)
 	: ExpNode(p), myNum(numIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
@@ -556,14 +569,14 @@ public:
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 private:
 	const int myNum;
 };
 
 class StrLitNode : public ExpNode{
 public:
-	StrLitNode(Position * p, const std::string strIn)
+	StrLitNode(Position p, const std::string strIn)
 	: ExpNode(p), myStr(strIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
@@ -571,7 +584,7 @@ public:
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * proc) override;
+	virtual OpdID flatten(Procedure * proc) override;
 private:
 	 const std::string myStr;
 };
@@ -580,31 +593,31 @@ private:
 
 class TrueNode : public ExpNode{
 public:
-	TrueNode(Position * p): ExpNode(p){ }
+	TrueNode(Position p): ExpNode(p){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class FalseNode : public ExpNode{
 public:
-	FalseNode(Position * p): ExpNode(p){ }
+	FalseNode(Position p): ExpNode(p){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	virtual Opd * flatten(Procedure * prog) override;
+	virtual OpdID flatten(Procedure * prog) override;
 };
 
 class CallStmtNode : public StmtNode{
 public:
-	CallStmtNode(Position * p, CallExpNode * expIn)
+	CallStmtNode(Position p, CallExpNode * expIn)
 	: StmtNode(p), myCallExp(expIn){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -0,0 +1,154 @@
+//Benchmark for CFG construction and analysis: builds 
+// procedures of 100k quads shaped like lowered cshanty 
+// (straight-line runs through fresh temps, if/else diamonds
+// and while loops, nested a few deep), then times building
+// each one's CFG and dominator tree and solving liveness.
+// Last, each procedure is taken into SSA form and back out.
+//
+// Build and run from the top-level directory with:
+//   make bench/cfg_build && bench/cfg_build
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "ssa.hpp"
+
+using namespace cshanty;
+
+static const size_t QUADS_PER_PROC = 100000;
+static const size_t PROCS = 10;
+static const size_t ROUNDS = 5;
+
+using Clock = std::chrono::steady_clock;
+
+static void addLabeledNop(Procedure * proc, LabelID label){
+	NopQuad nop;
+	nop.addLabel(label);
+	proc->addQuad(nop);
+}
+
+//Append a statement-like shape chosen by seed, recursing
+// into its body for nested control flow
+static void addShape(Procedure * proc, OpdID var, OpdID tmp,
+	unsigned seed, int depth){
+	OpdID one = proc->makeLit(1, 8);
+	switch (depth > 3 ? 0 : seed % 3){
+	case 0: {
+		//Like flattening, a fresh temp for each subexpression
+		OpdID sum = proc->makeTmp(8);
+		proc->addQuad(BinOpQuad(sum, ADD64, var, one));
+		proc->addQuad(BinOpQuad(tmp, MULT64, sum, var));
+		proc->addQuad(AssignQuad(var, tmp));
+		break;
+	}
+	case 1: {
+		LabelID elseLbl = proc->makeLabel();
+		LabelID after = proc->makeLabel();
+		proc->addQuad(BinOpQuad(tmp, LT64, var, one));
+		proc->addQuad(IfzQuad(tmp, elseLbl));
+		addShape(proc, var, tmp, seed / 3 + 7, depth + 1);
+		proc->addQuad(GotoQuad(after));
+		addLabeledNop(proc, elseLbl);
+		addShape(proc, var, tmp, seed / 5 + 3, depth + 1);
+		addLabeledNop(proc, after);
+		break;
+	}
+	case 2: {
+		LabelID head = proc->makeLabel();
+		LabelID after = proc->makeLabel();
+		addLabeledNop(proc, head);
+		proc->addQuad(BinOpQuad(tmp, NEQ64, var, one));
+		proc->addQuad(IfzQuad(tmp, after));
+		addShape(proc, var, tmp, seed / 7 + 1, depth + 1);
+		proc->addQuad(GotoQuad(head));
+		addLabeledNop(proc, after);
+		break;
+	}
+	}
+}
+
+int main(){
+	Interner names;
+	IRProgram * prog = new IRProgram(nullptr);
+	unsigned seed = 12345;
+	for (size_t p = 0; p < PROCS; p++){
+		Ident name = names.intern("proc" + std::to_string(p));
+		Procedure * proc = prog->makeProc(name);
+		OpdID var = proc->makeTmp(8);
+		OpdID tmp = proc->makeTmp(8);
+		while (proc->getBody().size() < QUADS_PER_PROC){
+			seed = seed * 1103515245u + 12345u;
+			addShape(proc, var, tmp, seed >> 8, 0);
+		}
+	}
+
+	size_t quads = 0;
+	size_t blocks = 0;
+	size_t edges = 0;
+	std::chrono::duration<double> buildTime(0);
+	std::chrono::duration<double> domTime(0);
+	std::chrono::duration<double> liveTime(0);
+	size_t temps = 0;
+	size_t slots = 0;
+	size_t visits = 0;
+	for (size_t round = 0; round < ROUNDS; round++){
+		for (Procedure * proc : *prog->getProcs()){
+			Clock::time_point start = Clock::now();
+			CFG cfg(proc);
+			Clock::time_point built = Clock::now();
+			cfg.computeDominators();
+			Clock::time_point dominated = Clock::now();
+			Liveness live(cfg);
+			Clock::time_point solved = Clock::now();
+			buildTime += built - start;
+			domTime += dominated - built;
+			liveTime += solved - dominated;
+			temps += proc->getTemps().size();
+			slots += live.numSlots();
+			visits += live.visits();
+
+			quads += proc->getBody().size();
+			blocks += cfg.numBlocks();
+			edges += cfg.numEdges();
+		}
+	}
+
+	//Leaving SSA form changes the procedure, so this is only
+	// done once, after the rounds above
+	std::chrono::duration<double> intoTime(0);
+	std::chrono::duration<double> outOfTime(0);
+	size_t phis = 0;
+	size_t copies = 0;
+	for (Procedure * proc : *prog->getProcs()){
+		Clock::time_point start = Clock::now();
+		phis += toSSA(proc);
+		Clock::time_point renamed = Clock::now();
+		copies += fromSSA(proc);
+		Clock::time_point restored = Clock::now();
+		intoTime += renamed - start;
+		outOfTime += restored - renamed;
+	}
+
+	double procs = static_cast<double>(PROCS * ROUNDS);
+	std::cout << quads / (PROCS * ROUNDS) << " quads, "
+		<< blocks / (PROCS * ROUNDS) << " blocks, "
+		<< edges / (PROCS * ROUNDS) << " edges per procedure\n";
+	std::cout << "CFG build:  " << buildTime.count() * 1000 / procs
+		<< " ms/procedure, "
+		<< static_cast<double>(quads) / buildTime.count() / 1e6
+		<< " M quads/s\n";
+	std::cout << "dominators: " << domTime.count() * 1000 / procs
+		<< " ms/procedure\n";
+	std::cout << "liveness:   " << liveTime.count() * 1000 / procs
+		<< " ms/procedure, " << temps / (PROCS * ROUNDS) << " temps, "
+		<< slots / (PROCS * ROUNDS) << " cross-block, "
+		<< static_cast<double>(visits) / static_cast<double>(blocks)
+		<< " visits/block\n";
+	std::cout << "into SSA:   " << intoTime.count() * 1000 / PROCS
+		<< " ms/procedure, " << phis / PROCS << " phis\n";
+	std::cout << "out of SSA: " << outOfTime.count() * 1000 / PROCS
+		<< " ms/procedure, " << copies / PROCS << " copies\n";
+	return 0;
+}
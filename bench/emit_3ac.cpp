@@ -0,0 +1,74 @@
+//Benchmark for 3AC output: builds a synthetic program of
+// about 1M quads in memory, writes it to a file, and 
+// reports the output rate, the memory the IR took per quad
+// and the process's peak RSS.
+//
+// Build and run from the top-level directory with:
+//   make bench/emit_3ac && bench/emit_3ac [out-file]
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+#include "3ac.hpp"
+
+using namespace cshanty;
+
+static const size_t PROCS = 1000;
+//Each block below adds 5 quads to a procedure
+static const size_t BLOCKS_PER_PROC = 200;
+
+using Clock = std::chrono::steady_clock;
+
+static long peakRSSKB(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+int main(int argc, char * argv[]){
+	const char * outPath = argc > 1 ? argv[1] : "/dev/null";
+
+	long rssBefore = peakRSSKB();
+	Interner names;
+	IRProgram * prog = new IRProgram(nullptr);
+	size_t quads = 0;
+	for (size_t p = 0; p < PROCS; p++){
+		Ident name = names.intern("proc" + std::to_string(p));
+		Procedure * proc = prog->makeProc(name);
+		for (size_t b = 0; b < BLOCKS_PER_PROC; b++){
+			OpdID a = proc->makeTmp(8);
+			OpdID c = proc->makeTmp(8);
+			LabelID top = proc->makeLabel();
+			AssignQuad head(a, proc->makeLit(7, 8));
+			head.addLabel(top);
+			proc->addQuad(head);
+			proc->addQuad(BinOpQuad(c, ADD64, a, a));
+			proc->addQuad(IfzQuad(c, proc->getLeaveLabel()));
+			proc->addQuad(SetArgQuad(1, c));
+			proc->addQuad(GotoQuad(top));
+			quads += 5;
+		}
+	}
+
+	long rssBuilt = peakRSSKB();
+
+	Clock::time_point start = Clock::now();
+	std::ofstream out;
+	static char buffer[1 << 20];
+	out.rdbuf()->pubsetbuf(buffer, sizeof(buffer));
+	out.open(outPath);
+	prog->emit(out);
+	std::streamoff bytes = out.tellp();
+	out.close();
+	std::chrono::duration<double> secs = Clock::now() - start;
+
+	double mb = static_cast<double>(bytes) / (1024 * 1024);
+	double irBytes = static_cast<double>(rssBuilt - rssBefore) * 1024;
+	std::cout << quads << " quads, " << mb << " MB in " 
+		<< secs.count() << " s: " << mb / secs.count() << " MB/s\n";
+	std::cout << "IR memory " << irBytes / static_cast<double>(quads)
+		<< " bytes/quad\n";
+	std::cout << "peak RSS " << peakRSSKB() / 1024 << " MB\n";
+	return 0;
+}
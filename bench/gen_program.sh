@@ -0,0 +1,235 @@
+#!/bin/sh
+# Writes a large, valid cshanty program to stdout, for timing
+# the compiler. The same arguments always give the same
+# program: choices come from a Park-Miller generator seeded
+# with SEED, not from awk's rand(), which differs between awks.
+#
+# Usage: bench/gen_program.sh <shape> [size] [seed]
+#
+# Shapes:
+#   nesting  if/else and while statements nested DEPTH deep
+#            (12 by default)
+#   wide     functions with many formals, locals and statements
+#   exprs    long arithmetic and logical expression chains
+#   globals  many int, bool and string globals read and written
+#            by every function
+#   strings  string literals (with escapes) reported and passed
+#            to functions
+#   records  many record types, record variables and field
+#            accesses
+#   mixed    a little of everything
+#
+# SIZE (default 1000) is the number of functions, each some
+# 20 to 70 lines long. main calls each of them once, with
+# fixed arguments, and reports what they return, so the
+# programs can also be run (--run, --jit or -o) and their
+# output compared.
+
+SHAPE=$1
+SIZE=${2:-1000}
+SEED=${3:-1}
+DEPTH=${DEPTH:-12}
+
+case "$SHAPE" in
+nesting|wide|exprs|globals|strings|records|mixed) ;;
+*)
+	echo "Usage: $0 nesting|wide|exprs|globals|strings|records|mixed [size] [seed]" >&2
+	exit 1
+	;;
+esac
+
+awk -v shape="$SHAPE" -v size="$SIZE" -v seed="$SEED" -v depth="$DEPTH" '
+function rnd(n) {
+	state = (state * 16807) % 2147483647
+	return state % n
+}
+function ind(depth,    s) {
+	s = ""
+	while (depth-- > 0) { s = s "\t" }
+	return s
+}
+function intExp(vars, n, len,    s, i, ops, op) {
+	ops = "+-*+-*/"
+	s = vars[rnd(n)]
+	for (i = 1; i < len; i++) {
+		op = substr(ops, rnd(7) + 1, 1)
+		if (op == "/") {
+			s = s " / " (rnd(9) + 1)
+		} else if (rnd(4) == 0) {
+			s = "(" s ") " op " " vars[rnd(n)]
+		} else {
+			s = s " " op " " (rnd(3) ? vars[rnd(n)] : rnd(1000))
+		}
+	}
+	return s
+}
+function boolExp(vars, n, len,    s, i, cmp, c) {
+	s = vars[rnd(n)] " < " vars[rnd(n)]
+	for (i = 1; i < len; i++) {
+		cmp = rnd(4)
+		if (cmp == 0) { c = vars[rnd(n)] " == " rnd(100) }
+		else if (cmp == 1) { c = vars[rnd(n)] " >= " vars[rnd(n)] }
+		else if (cmp == 2) { c = "!(" vars[rnd(n)] " != " vars[rnd(n)] ")" }
+		else { c = vars[rnd(n)] " > " rnd(100) }
+		s = s (rnd(2) ? " && " : " || ") c
+	}
+	return s
+}
+function strLit(    s, k, words) {
+	split("ahoy,heave,ho,the,anchor,sea,shanty,rum,deck,sail,wind,mast", words, ",")
+	s = ""
+	for (k = rnd(6) + 2; k > 0; k--) {
+		s = s words[rnd(12) + 1] (rnd(5) == 0 ? "\\t" : " ")
+	}
+	if (rnd(3) == 0) { s = s "\\\"quoted\\\"" }
+	return "\"" s "\\n\""
+}
+
+# Nested control flow around assignments to a, b and c
+function nested(depth, max,    pad, k) {
+	pad = ind(depth + 1)
+	printf "%sa = a + %d;\n", pad, rnd(10) + 1
+	if (depth >= max) {
+		printf "%sreport a * b - c;\n", pad
+		return
+	}
+	k = rnd(3)
+	if (k == 0) {
+		printf "%sif (a < b + %d) {\n", pad, rnd(50)
+		nested(depth + 1, max)
+		printf "%s} else {\n", pad
+		printf "%s\tb = b - %d;\n", pad, rnd(5) + 1
+		printf "%s}\n", pad
+	} else if (k == 1) {
+		printf "%swhile (c > %d) {\n", pad, rnd(10)
+		printf "%s\tc = c - 1;\n", pad
+		nested(depth + 1, max)
+		printf "%s}\n", pad
+	} else {
+		printf "%sif (b >= a) {\n", pad
+		nested(depth + 1, max)
+		printf "%s}\n", pad
+	}
+}
+
+function genNesting(f) {
+	printf "int nest_%d(int a, int b){\n\tint c;\n\tc = a + b;\n", f
+	nested(0, depth)
+	printf "\treturn a + b + c;\n}\n"
+	calls[f] = sprintf("report nest_%d(3, 5);", f)
+}
+
+function genWide(f,    nformals, nlocals, vars, n, i, args) {
+	nformals = 6 + rnd(6)
+	nlocals = 20 + rnd(20)
+	n = 0
+	printf "int wide_%d(", f
+	for (i = 0; i < nformals; i++) {
+		printf "%sint p%d", (i ? ", " : ""), i
+		vars[n++] = "p" i
+	}
+	printf "){\n"
+	for (i = 0; i < nlocals; i++) {
+		printf "\tint v%d;\n", i
+	}
+	for (i = 0; i < nlocals; i++) {
+		printf "\tv%d = %s;\n", i, intExp(vars, n, 2 + rnd(3))
+		vars[n++] = "v" i
+	}
+	printf "\treturn %s;\n}\n", intExp(vars, n, 4)
+	args = "1"
+	for (i = 1; i < nformals; i++) { args = args ", " (i + 1) }
+	calls[f] = sprintf("report wide_%d(%s);", f, args)
+}
+
+function genExprs(f,    vars, n, i) {
+	n = 0
+	vars[n++] = "x"; vars[n++] = "y"; vars[n++] = "z"; vars[n++] = "w"
+	printf "int expr_%d(int x, int y, int z){\n\tint w;\n\tbool t;\n", f
+	printf "\tw = %s;\n", intExp(vars, 3, 20 + rnd(20))
+	for (i = 0; i < 3; i++) {
+		printf "\tt = %s;\n", boolExp(vars, n, 8 + rnd(8))
+		printf "\tif (t) {\n\t\tw = %s;\n\t}\n", intExp(vars, n, 30 + rnd(30))
+	}
+	printf "\treturn %s;\n}\n", intExp(vars, n, 40)
+	calls[f] = sprintf("report expr_%d(1, 2, 3);", f)
+}
+
+# Each call declares ten more globals of each type, and reads
+# ones declared by any call before. Strings cannot be assigned,
+# so the string globals are declared but never reported.
+function genGlobals(f,    i, g, src) {
+	for (i = 0; i < 10; i++) {
+		g = nglobals + i
+		printf "int gi_%d;\nbool gb_%d;\nstring gs_%d;\n", g, g, g
+	}
+	nglobals += 10
+	printf "void glob_%d(int a){\n", f
+	for (i = 0; i < 10; i++) {
+		g = nglobals - 10 + i
+		src = rnd(nglobals)
+		printf "\tgi_%d = gi_%d + a * %d;\n", g, src, rnd(10) + 1
+		printf "\tgb_%d = gi_%d > gi_%d;\n", g, src, g
+		if (rnd(3) == 0) { printf "\treport gb_%d;\n", src }
+	}
+	printf "\treceive gi_%d;\n\treturn;\n}\n", nglobals - 10
+	calls[f] = sprintf("glob_%d(%d);\n\treport gi_%d;", f, f % 10, nglobals - 1)
+}
+
+function genStrings(f,    i) {
+	printf "void str_%d(string s, string t, int n){\n", f
+	for (i = 0; i < 12; i++) {
+		printf "\treport %s;\n", strLit()
+		if (rnd(3) == 0) { printf "\treport %s;\n", (rnd(2) ? "s" : "t") }
+	}
+	printf "\tif (n > 0) {\n\t\tstr_%d(%s, s, n - 1);\n\t}\n", f, strLit()
+	printf "\treturn;\n}\n"
+	calls[f] = sprintf("str_%d(\"s\", \"t\", 1);", f)
+}
+
+function genRecords(f,    i) {
+	printf "record Rec_%d {\n", f
+	for (i = 0; i < 8; i++) {
+		printf "\tint f%d;\n\tbool b%d;\n", i, i
+	}
+	printf "\tstring tag;\n}\n"
+	printf "Rec_%d grec_%d;\n", f, f
+	printf "int rec_%d(int a){\n\tRec_%d r;\n\tRec_%d s;\n", f, f, f
+	#Locals start out undefined, so every int field is set
+	# before anything reads it
+	for (i = 0; i < 8; i++) {
+		printf "\tr[f%d] = a + %d;\n\ts[f%d] = %d;\n", i, rnd(10), i, rnd(100)
+	}
+	for (i = 0; i < 8; i++) {
+		printf "\tr[f%d] = a + grec_%d[f%d] * %d;\n", i, f, rnd(8), rnd(10) + 1
+		printf "\ts[b%d] = r[f%d] > s[f%d];\n", i, i, rnd(8)
+		printf "\tif (s[b%d]) {\n\t\tgrec_%d[f%d] = r[f%d] - 1;\n\t}\n", i, f, i, i
+	}
+	#(not tag: strings cannot be assigned, so it is never set)
+	printf "\treport grec_%d[b%d];\n", f, rnd(8)
+	printf "\treturn r[f0] + s[f7];\n}\n"
+	calls[f] = sprintf("report rec_%d(%d);", f, f % 10)
+}
+
+BEGIN {
+	state = seed % 2147483646 + 1
+	for (f = 0; f < size; f++) {
+		s = shape
+		if (s == "mixed") {
+			split("nesting,wide,exprs,globals,strings,records", kinds, ",")
+			s = kinds[rnd(6) + 1]
+		}
+		if (s == "nesting") { genNesting(f) }
+		else if (s == "wide") { genWide(f) }
+		else if (s == "exprs") { genExprs(f) }
+		else if (s == "globals") { genGlobals(f) }
+		else if (s == "strings") { genStrings(f) }
+		else { genRecords(f) }
+	}
+	print "int main(){"
+	for (f = 0; f < size; f++) {
+		printf "\t%s\n\treport \"\\n\";\n", calls[f]
+	}
+	print "\treturn 0;"
+	print "}"
+}'
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Measures lexing throughput (MB/s) of the token dump path (-t).
+#
+# Usage: bench/lex_throughput.sh [cshantyc] [baseline-cshantyc]
+#
+# The first binary defaults to ./cshantyc. If a second binary is
+# given (for example one built from an older revision, which
+# scans through an ifstream), it is run on the same input so the
+# two can be compared directly.
+
+CSHANTYC=${1:-./cshantyc}
+BASELINE=$2
+REPS=${REPS:-5}
+COPIES=${COPIES:-20000}
+
+INPUT=$(mktemp /tmp/lexbench.XXXXXX)
+trap 'rm -f "$INPUT"' EXIT
+
+# Replicate a block that exercises every token class
+awk -v copies="$COPIES" 'BEGIN {
+	for (i = 0; i < copies; i++) {
+		printf "int fn_%d(int alpha, bool beta){\n", i
+		printf "\tstring s;\n\ts = \"a string \\\"literal\\\" with escapes\\n\";\n"
+		printf "\tif (alpha >= 12345 && !beta || alpha != 7) { alpha = alpha * 3 - 1; }\n"
+		printf "\twhile (beta) { alpha++; beta = alpha < 100; } // comment\n"
+		printf "\treport s;\n\treturn alpha / 2;\n}\n"
+	}
+}' > "$INPUT"
+
+BYTES=$(wc -c < "$INPUT")
+
+run() {
+	BIN=$1
+	START=$(date +%s.%N)
+	i=0
+	while [ $i -lt "$REPS" ]; do
+		"$BIN" "$INPUT" -t /dev/null || exit 1
+		i=$((i + 1))
+	done
+	END=$(date +%s.%N)
+	echo "$START $END $BYTES $REPS" | awk -v bin="$BIN" '{
+		secs = ($2 - $1) / $4
+		printf "%-40s %8.3f s/run %8.2f MB/s\n", bin, secs, ($3 / 1048576) / secs
+	}'
+}
+
+echo "input: $BYTES bytes, $REPS runs each"
+run "$CSHANTYC"
+if [ -n "$BASELINE" ]; then
+	run "$BASELINE"
+fi
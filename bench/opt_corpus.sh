@@ -0,0 +1,87 @@
+#!/bin/sh
+# Reports how much the -O passes shrink the 3AC of a corpus of
+# generated programs: quads and temps before and after, and
+# how many quads or temps each pass folded, reused, propagated,
+# deleted or coalesced. Then registers are allocated (REGS of
+# them, 6 by default), and the report counts the variables
+# left in memory, the spill and reload quads added around
+# calls and the frame slots saved.
+#
+# Usage: bench/opt_corpus.sh [cshantyc]
+#
+# The programs mix the shapes the passes look for: repeated
+# subexpressions (a * b + a * b), arithmetic on constants,
+# branches on constant conditions and values computed but
+# never used.
+
+CSHANTYC=${1:-./cshantyc}
+FILES=${FILES:-20}
+FNS=${FNS:-200}
+REGS=${REGS:-6}
+
+DIR=$(mktemp -d /tmp/optbench.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+i=0
+while [ $i -lt "$FILES" ]; do
+	awk -v fns="$FNS" -v seed="$i" 'BEGIN {
+		srand(seed)
+		print "int total;"
+		for (f = 0; f < fns; f++) {
+			printf "int fn_%d(int a, int b){\n", f
+			printf "\tint x;\n\tint y;\n\tint k;\n\tbool c;\n"
+			printf "\tk = %d;\n", int(rand() * 50)
+			printf "\tx = a * b + a * b;\n"
+			printf "\ty = (a + k) * (k + a) - (a + k);\n"
+			printf "\tc = k * 2 > %d;\n", int(rand() * 100)
+			printf "\tif (c) {\n\t\tx = x + k * 3;\n\t} else {\n\t\ty = y - 1;\n\t}\n"
+			printf "\twhile (a < b) {\n\t\ta = a + (b - a) / 2 + 1;\n\t\ttotal = total + a * b;\n\t}\n"
+			printf "\tk = x * y;\n"
+			printf "\treport a * b - b * a;\n"
+			printf "\treturn x + y;\n}\n"
+		}
+	}' > "$DIR/prog_$i.cshanty"
+	i=$((i + 1))
+done
+
+for f in "$DIR"/*.cshanty; do
+	"$CSHANTYC" "$f" --opt-report --regs "$REGS" -a /dev/null 2>&1 || exit 1
+done | awk '
+	/^optimized/ {
+		gsub(/[(),;]/, " ")
+		quads += $2; after += $4; temps += $6; tempsAfter += $8
+		for (i = 10; i < NF; i++) {
+			if ($(i + 1) == "folded") folded += $i
+			if ($(i + 1) == "recomputations") reused += $i
+			if ($(i + 1) == "copies") copies += $i
+			if ($(i + 1) == "dead") dead += $i
+			if ($(i + 1) == "temps") dropped += $i
+			if ($(i + 1) == "coalesced") coalesced += $i
+		}
+	}
+	/^allocated/ {
+		gsub(/[(),]/, " ")
+		inRegs += $2; vars += $4
+		for (i = 7; i < NF; i++) {
+			if ($(i + 1) == "spilled") spilled += $i
+			if ($(i + 1) == "spill") spills += $i
+			if ($(i + 1) == "reload") reloads += $i
+			if ($(i + 1) == "slots") saved += $i
+			if ($(i + 1) == "colored") colored += $i
+		}
+	}
+	END {
+		printf "%d quads -> %d (%.1f%% removed)\n", quads, after,
+			quads ? 100 * (quads - after) / quads : 0
+		printf "%d temps -> %d (%.1f%% removed)\n", temps, tempsAfter,
+			temps ? 100 * (temps - tempsAfter) / temps : 0
+		printf "  constant propagation: %d quads folded or removed\n", folded
+		printf "  value numbering:      %d recomputations turned into copies\n", reused
+		printf "  copy propagation:     %d reads or copies rewritten\n", copies
+		printf "  dead code:            %d quads deleted, %d temps dropped\n", dead, dropped
+		printf "  coalescing:           %d temps merged into shared slots\n", coalesced
+		printf "%d of %d variables in registers (%d spilled, %d functions colored)\n",
+			inRegs, vars, spilled, colored
+		printf "  %d spill and %d reload quads around calls, %d frame slots saved\n",
+			spills, reloads, saved
+	}'
@@ -0,0 +1,93 @@
+#!/bin/sh
+# Times each phase of the compiler on large generated programs
+# (see gen_program.sh), one program per shape, and reports
+# throughput against a saved baseline:
+#   lines/s  source lines over the front end (parse, which
+#            includes scanning, name and type analysis)
+#   quads/s  quads built by to3AC over the back end (to3AC,
+#            -O, register allocation and writing assembly)
+# The times are those --stats reports, the best of REPS runs
+# for each phase.
+#
+# Usage: bench/pipeline.sh [cshantyc]
+#
+# SIZE functions go in each program (1000 by default). The
+# baseline is read from BASELINE (bench/pipeline.baseline).
+# The first run, or any run with SAVE=1, writes its numbers
+# there. They are only comparable on the machine that made
+# them, so the file is not checked in.
+
+CSHANTYC=${1:-./cshantyc}
+SIZE=${SIZE:-1000}
+REPS=${REPS:-3}
+BASELINE=${BASELINE:-$(dirname "$0")/pipeline.baseline}
+SHAPES="nesting wide exprs globals strings records mixed"
+
+DIR=$(mktemp -d /tmp/pipebench.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+for shape in $SHAPES; do
+	sh "$(dirname "$0")/gen_program.sh" "$shape" "$SIZE" > "$DIR/$shape.cshanty" || exit 1
+	i=0
+	while [ $i -lt "$REPS" ]; do
+		"$CSHANTYC" "$DIR/$shape.cshanty" -O --regs 6 -o /dev/null \
+			--stats "$DIR/$shape.$i.json" || exit 1
+		i=$((i + 1))
+	done
+	# One line per shape: its name, lines, quads and the best
+	# time of each phase
+	LINES=$(wc -l < "$DIR/$shape.cshanty")
+	cat "$DIR/$shape".*.json | awk -v shape="$shape" -v lines="$LINES" '
+		/"name":/ {
+			gsub(/[{}",:]/, " ")
+			ms = $4
+			if (!($2 in best) || ms < best[$2]) best[$2] = ms
+		}
+		/"quads":/ { gsub(/[",:]/, " "); quads = $2 }
+		END {
+			front = best["parse"] + best["name_analysis"] + best["type_analysis"]
+			back = best["to3AC"] + best["optimize"] + best["regalloc"] + best["writeX64"]
+			printf "%s %d %d %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f\n",
+				shape, lines, quads, best["scan"], best["parse"],
+				best["name_analysis"], best["type_analysis"], best["to3AC"],
+				best["optimize"], best["regalloc"], best["writeX64"], front, back
+		}'
+done > "$DIR/results"
+
+awk -v baseline="$BASELINE" '
+	BEGIN {
+		while ((getline line < baseline) > 0) {
+			if (line ~ /^#/) continue
+			split(line, f, " ")
+			baseLines[f[1]] = f[2]
+			baseQuads[f[1]] = f[3]
+		}
+		printf "%-8s %7s %7s %7s %7s %7s %7s %7s %7s %7s %7s %11s %8s %11s %8s\n",
+			"shape", "lines", "quads", "scan", "parse", "names", "types",
+			"3ac", "opt", "regs", "x64", "lines/s", "vs base", "quads/s", "vs base"
+	}
+	function delta(now, base) {
+		if (base <= 0 || now <= 0) return sprintf("%8s", "-")
+		return sprintf("%+7.1f%%", 100 * (now - base) / base)
+	}
+	{
+		linesRate = $12 > 0 ? $2 / ($12 / 1000) : 0
+		quadsRate = $13 > 0 && $3 > 0 ? $3 / ($13 / 1000) : 0
+		printf "%-8s %7d %7d %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f %11.0f %s %11.0f %s\n",
+			$1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11,
+			linesRate, delta(linesRate, baseLines[$1]),
+			quadsRate, delta(quadsRate, baseQuads[$1])
+		rates = rates sprintf("%s %.0f %.0f\n", $1, linesRate, quadsRate)
+	}
+	END {
+		print "(phase times in ms, best of each phase over the runs)"
+		printf "%s", rates > (FILENAME ".rates")
+	}' "$DIR/results"
+
+if [ -n "$SAVE" ] || [ ! -f "$BASELINE" ]; then
+	{
+		echo "# shape lines/s quads/s, written by bench/pipeline.sh"
+		cat "$DIR/results.rates"
+	} > "$BASELINE"
+	echo "saved baseline to $BASELINE"
+fi
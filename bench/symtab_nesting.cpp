@@ -0,0 +1,88 @@
+//Microbenchmark for the scoped symbol table: opens 10k 
+// nested scopes, each declaring a name of its own and
+// shadowing a name shared by every scope, looks names up
+// from the innermost scope, then unwinds everything.
+//
+// Build and run from the top-level directory with:
+//   make bench/symtab_nesting && bench/symtab_nesting
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "symbol_table.hpp"
+
+using namespace cshanty;
+
+static const size_t DEPTH = 10000;
+static const size_t LOOKUPS = 1000000;
+static const size_t ROUNDS = 10;
+
+using Clock = std::chrono::steady_clock;
+
+static double nsPer(Clock::time_point start, size_t ops){
+	std::chrono::duration<double, std::nano> elapsed = 
+		Clock::now() - start;
+	return elapsed.count() / static_cast<double>(ops);
+}
+
+int main(){
+	Interner names;
+	Ident global = names.intern("global");
+	Ident shared = names.intern("shared");
+	std::vector<Ident> locals;
+	for (size_t i = 0; i < DEPTH; i++){
+		locals.push_back(names.intern("local_" + std::to_string(i)));
+	}
+	const DataType * intTy = BasicType::INT();
+
+	//Symbols are made up front so only the table is timed
+	std::vector<SemSymbol *> sharedSyms, localSyms;
+	for (size_t i = 0; i < DEPTH; i++){
+		sharedSyms.push_back(new VarSymbol(shared, intTy));
+		localSyms.push_back(new VarSymbol(locals[i], intTy));
+	}
+
+	double enterNs = 0, lookupNs = 0, leaveNs = 0;
+	size_t found = 0;
+	for (size_t round = 0; round < ROUNDS; round++){
+		SymbolTable table;
+		table.enterScope();
+		table.insert(new VarSymbol(global, intTy));
+
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < DEPTH; i++){
+			table.enterScope();
+			table.insert(sharedSyms[i]);
+			table.insert(localSyms[i]);
+		}
+		enterNs += nsPer(start, DEPTH);
+
+		//Outermost, innermost and shadowed names alike
+		start = Clock::now();
+		for (size_t i = 0; i < LOOKUPS; i++){
+			Ident name;
+			switch (i % 3){
+			case 0: name = global; break;
+			case 1: name = shared; break;
+			default: name = locals[i % DEPTH]; break;
+			}
+			if (table.find(name) != nullptr){ found++; }
+		}
+		lookupNs += nsPer(start, LOOKUPS);
+
+		start = Clock::now();
+		for (size_t i = 0; i < DEPTH; i++){
+			table.leaveScope();
+		}
+		leaveNs += nsPer(start, DEPTH);
+		table.leaveScope();
+	}
+
+	std::cout << "depth " << DEPTH << ", " << ROUNDS << " rounds"
+		<< " (" << found << " hits)\n";
+	std::cout << "enter+2 inserts: " << enterNs / ROUNDS << " ns/scope\n";
+	std::cout << "lookup:          " << lookupNs / ROUNDS << " ns/find\n";
+	std::cout << "leave:           " << leaveNs / ROUNDS << " ns/scope\n";
+	return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef CSHANTY_BITSET_HPP
+#define CSHANTY_BITSET_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace cshanty{
+
+//A fixed-size set of small integers, stored one bit per
+// member in 64-bit words. Union and difference work a word
+// at a time, which is what makes bit-vector dataflow cheap.
+class BitSet{
+public:
+	BitSet() : mySize(0){ }
+	explicit BitSet(size_t sizeIn)
+	: words((sizeIn + 63) / 64, 0), mySize(sizeIn){ }
+
+	size_t size() const { return mySize; }
+	bool test(size_t idx) const {
+		return (words[idx / 64] >> (idx % 64)) & 1;
+	}
+	void set(size_t idx){ words[idx / 64] |= bit(idx); }
+	void reset(size_t idx){ words[idx / 64] &= ~bit(idx); }
+	void clear(){
+		for (uint64_t& word : words){ word = 0; }
+	}
+
+	//Add every member of other, returning true if this set
+	// grew. Both sets must be the same size.
+	bool unionWith(const BitSet& other){
+		uint64_t grew = 0;
+		for (size_t i = 0; i < words.size(); i++){
+			uint64_t merged = words[i] | other.words[i];
+			grew |= merged ^ words[i];
+			words[i] = merged;
+		}
+		return grew != 0;
+	}
+
+	//Set this to gen | (in & ~kill), returning true if that
+	// changed it. All four sets must be the same size.
+	bool assignTransfer(const BitSet& gen, const BitSet& in,
+		const BitSet& kill){
+		uint64_t changed = 0;
+		for (size_t i = 0; i < words.size(); i++){
+			uint64_t next = gen.words[i] | (in.words[i] & ~kill.words[i]);
+			changed |= next ^ words[i];
+			words[i] = next;
+		}
+		return changed != 0;
+	}
+
+	size_t count() const{
+		size_t res = 0;
+		for (uint64_t word : words){
+			res += static_cast<size_t>(__builtin_popcountll(word));
+		}
+		return res;
+	}
+
+	//Call visit(idx) for each member, in increasing order
+	template <typename F>
+	void forEach(F visit) const{
+		for (size_t i = 0; i < words.size(); i++){
+			uint64_t word = words[i];
+			while (word != 0){
+				size_t low = static_cast<size_t>(__builtin_ctzll(word));
+				visit(i * 64 + low);
+				word &= word - 1;
+			}
+		}
+	}
+
+	bool operator==(const BitSet& other) const {
+		return words == other.words;
+	}
+	bool operator!=(const BitSet& other) const {
+		return words != other.words;
+	}
+private:
+	static uint64_t bit(size_t idx){
+		return static_cast<uint64_t>(1) << (idx % 64);
+	}
+
+	std::vector<uint64_t> words;
+	size_t mySize;
+};
+
+}
+
+#endif
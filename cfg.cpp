@@ -0,0 +1,252 @@
+#include <sstream>
+#include "cfg.hpp"
+
+namespace cshanty{
+
+CFG::CFG(Procedure * proc) : myProc(proc){
+	findBlocks();
+	linkBlocks();
+	orderBlocks();
+}
+
+void CFG::findBlocks(){
+	const std::vector<Quad>& body = myProc->getBody();
+	size_t count = body.size();
+
+	//A block starts at every labeled quad and after every
+	// jump; the exit block starts (and ends) after the last
+	// quad
+	std::vector<bool> leader(count + 1, false);
+	for (size_t i = 0; i < count; i++){
+		if (i == 0 || body[i].getLabel() != NO_LABEL){
+			leader[i] = true;
+		}
+		QuadOp op = body[i].getOp();
+		if (op == QuadOp::GOTO || op == QuadOp::IFZ){
+			leader[i + 1] = true;
+		}
+	}
+	leader[count] = true;
+
+	quadBlock.resize(count);
+	for (size_t i = 0; i <= count; i++){
+		if (leader[i]){ blockStart.push_back(i); }
+		if (i < count){
+			quadBlock[i] = static_cast<BlockID>(blockStart.size() - 1);
+		}
+	}
+	blockStart.push_back(count);
+
+	for (size_t i = 0; i < count; i++){
+		LabelID label = body[i].getLabel();
+		if (label != NO_LABEL){ labelBlocks[label] = quadBlock[i]; }
+	}
+	labelBlocks[myProc->getLeaveLabel()] = exit();
+}
+
+BlockID CFG::blockOfLabel(LabelID label) const{
+	auto found = labelBlocks.find(label);
+	if (found == labelBlocks.end()){
+		throw new InternalError("Jump to a label outside the procedure");
+	}
+	return found->second;
+}
+
+void CFG::linkBlocks(){
+	const std::vector<Quad>& body = myProc->getBody();
+	size_t blocks = numBlocks();
+
+	succStart.reserve(blocks + 1);
+	for (BlockID b = 0; b < blocks; b++){
+		succStart.push_back(static_cast<uint32_t>(succList.size()));
+		if (b == exit()){ continue; }
+
+		const Quad& last = body[end(b) - 1];
+		BlockID next = b + 1;
+		if (last.getOp() == QuadOp::GOTO){
+			succList.push_back(blockOfLabel(last.getTarget()));
+		} else if (last.getOp() == QuadOp::IFZ){
+			BlockID target = blockOfLabel(last.getTarget());
+			succList.push_back(next);
+			if (target != next){ succList.push_back(target); }
+		} else {
+			succList.push_back(next);
+		}
+	}
+	succStart.push_back(static_cast<uint32_t>(succList.size()));
+
+	//Predecessors are the same edges, bucketed by target
+	predStart.assign(blocks + 1, 0);
+	for (BlockID succ : succList){ predStart[succ + 1]++; }
+	for (size_t b = 0; b < blocks; b++){ predStart[b + 1] += predStart[b]; }
+	predList.resize(succList.size());
+	std::vector<uint32_t> fill(predStart.begin(), predStart.end() - 1);
+	for (BlockID b = 0; b < blocks; b++){
+		for (BlockID succ : succs(b)){
+			predList[fill[succ]++] = b;
+		}
+	}
+}
+
+void CFG::orderBlocks(){
+	size_t blocks = numBlocks();
+	rpoIndex.assign(blocks, NO_BLOCK);
+
+	//Iterative depth-first search, so deep graphs can't
+	// overflow the stack. Each frame is a block and the
+	// index of the next successor to visit.
+	std::vector<bool> seen(blocks, false);
+	std::vector<std::pair<BlockID, uint32_t>> stack;
+	std::vector<BlockID> postorder;
+	postorder.reserve(blocks);
+	stack.push_back(std::make_pair(entry(), 0u));
+	seen[entry()] = true;
+	while (!stack.empty()){
+		BlockID block = stack.back().first;
+		uint32_t& nextSucc = stack.back().second;
+		BlockRange out = succs(block);
+		if (nextSucc < out.size()){
+			BlockID succ = out[nextSucc++];
+			if (!seen[succ]){
+				seen[succ] = true;
+				stack.push_back(std::make_pair(succ, 0u));
+			}
+		} else {
+			postorder.push_back(block);
+			stack.pop_back();
+		}
+	}
+
+	myRPO.assign(postorder.rbegin(), postorder.rend());
+	for (size_t i = 0; i < myRPO.size(); i++){
+		rpoIndex[myRPO[i]] = static_cast<BlockID>(i);
+	}
+}
+
+void CFG::computeDominators(){
+	if (hasDominators()){ return; }
+	size_t blocks = numBlocks();
+
+	//Cooper, Harvey and Kennedy's iterative algorithm:
+	// visit blocks in reverse postorder, intersecting the
+	// dominators of each block's processed predecessors,
+	// until nothing changes
+	idoms.assign(blocks, NO_BLOCK);
+	idoms[entry()] = entry();
+	bool changed = true;
+	while (changed){
+		changed = false;
+		for (size_t i = 1; i < myRPO.size(); i++){
+			BlockID block = myRPO[i];
+			BlockID newIdom = NO_BLOCK;
+			for (BlockID pred : preds(block)){
+				if (idoms[pred] == NO_BLOCK){ continue; }
+				if (newIdom == NO_BLOCK){
+					newIdom = pred;
+					continue;
+				}
+				BlockID a = pred;
+				BlockID b = newIdom;
+				while (a != b){
+					while (rpoIndex[a] > rpoIndex[b]){ a = idoms[a]; }
+					while (rpoIndex[b] > rpoIndex[a]){ b = idoms[b]; }
+				}
+				newIdom = a;
+			}
+			if (idoms[block] != newIdom){
+				idoms[block] = newIdom;
+				changed = true;
+			}
+		}
+	}
+	idoms[entry()] = NO_BLOCK;
+
+	domKidStart.assign(blocks + 1, 0);
+	for (BlockID b = 0; b < blocks; b++){
+		if (idoms[b] != NO_BLOCK){ domKidStart[idoms[b] + 1]++; }
+	}
+	for (size_t b = 0; b < blocks; b++){ domKidStart[b + 1] += domKidStart[b]; }
+	domKids.resize(domKidStart[blocks]);
+	std::vector<uint32_t> fill(domKidStart.begin(), domKidStart.end() - 1);
+	for (BlockID b = 0; b < blocks; b++){
+		if (idoms[b] != NO_BLOCK){ domKids[fill[idoms[b]]++] = b; }
+	}
+
+	domPre.assign(blocks, 0);
+	domPost.assign(blocks, 0);
+	uint32_t clock = 0;
+	std::vector<std::pair<BlockID, uint32_t>> stack;
+	stack.push_back(std::make_pair(entry(), 0u));
+	domPre[entry()] = clock++;
+	while (!stack.empty()){
+		BlockID block = stack.back().first;
+		uint32_t& nextKid = stack.back().second;
+		BlockRange kids = domChildren(block);
+		if (nextKid < kids.size()){
+			BlockID kid = kids[nextKid++];
+			domPre[kid] = clock++;
+			stack.push_back(std::make_pair(kid, 0u));
+		} else {
+			domPost[block] = clock++;
+			stack.pop_back();
+		}
+	}
+}
+
+bool CFG::dominates(BlockID a, BlockID b) const{
+	if (!hasDominators()){
+		throw new InternalError("Dominators were never computed");
+	}
+	if (!reachable(a) || !reachable(b)){ return false; }
+	return domPre[a] <= domPre[b] && domPost[b] <= domPost[a];
+}
+
+//Escape text for a DOT string, ending each line left-justified
+static void writeDotText(std::ostream& out, const std::string& text){
+	for (char c : text){
+		if (c == '"' || c == '\\'){ out.put('\\'); }
+		out.put(c);
+	}
+	out << "\\l";
+}
+
+void CFG::writeDot(std::ostream& out) const{
+	const std::vector<Quad>& body = myProc->getBody();
+	std::string name = myProc->getName();
+	out << "  subgraph \"cluster_" << name << "\" {\n";
+	out << "    label=\"" << name << "\";\n";
+	for (BlockID b = 0; b < numBlocks(); b++){
+		out << "    \"" << name << "." << b << "\" [label=\"B" << b;
+		if (!reachable(b)){ out << " (unreachable)"; }
+		out << "\\l";
+		if (b == entry()){
+			writeDotText(out, myProc->getEnter().toString(myProc));
+		}
+		for (size_t i = first(b); i < end(b); i++){
+			writeDotText(out, body[i].toString(myProc));
+		}
+		if (b == exit()){
+			writeDotText(out, myProc->getLeave().toString(myProc));
+		}
+		out << "\"];\n";
+	}
+	for (BlockID b = 0; b < numBlocks(); b++){
+		for (BlockID succ : succs(b)){
+			out << "    \"" << name << "." << b << "\" -> \""
+				<< name << "." << succ << "\";\n";
+		}
+	}
+	out << "  }\n";
+}
+
+void writeDotFile(IRProgram * prog, std::ostream& out){
+	out << "digraph cfg {\n";
+	out << "  node [shape=box, fontname=\"monospace\"];\n";
+	for (Procedure * proc : *prog->getProcs()){
+		CFG cfg(proc);
+		cfg.writeDot(out);
+	}
+	out << "}\n";
+}
+
+}
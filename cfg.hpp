@@ -0,0 +1,125 @@
+#ifndef CSHANTY_CFG_HPP
+#define CSHANTY_CFG_HPP
+
+#include <ostream>
+#include <stdint.h>
+#include <vector>
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//Blocks are referred to by number. Block 0 is the entry
+// block; the last block is an empty exit block standing
+// for the procedure's leave quad.
+typedef uint32_t BlockID;
+static const BlockID NO_BLOCK = UINT32_MAX;
+
+//A run of block ids, e.g. the successors of a block
+class BlockRange{
+public:
+	BlockRange(const BlockID * beginIn, const BlockID * endIn)
+	: myBegin(beginIn), myEnd(endIn){ }
+	const BlockID * begin() const { return myBegin; }
+	const BlockID * end() const { return myEnd; }
+	size_t size() const { return static_cast<size_t>(myEnd - myBegin); }
+	bool empty() const { return myBegin == myEnd; }
+	BlockID operator[](size_t idx) const { return myBegin[idx]; }
+private:
+	const BlockID * myBegin;
+	const BlockID * myEnd;
+};
+
+//The control-flow graph of one procedure. A block is a
+// range of indices into the procedure's body, split after
+// every jump and before every labeled quad. Edges are held
+// in compressed arrays (one flat array of successors, one
+// of predecessors, each indexed by per-block offsets), so
+// building the graph is a couple of linear passes and
+// walking it never chases pointers.
+//
+//The graph describes the body as it was when the CFG was
+// built; a pass that adds, removes or reorders quads must
+// build a new one.
+class CFG{
+public:
+	explicit CFG(Procedure * proc);
+
+	Procedure * getProc() const { return myProc; }
+	size_t numBlocks() const { return blockStart.size() - 1; }
+	BlockID entry() const { return 0; }
+	BlockID exit() const { return static_cast<BlockID>(numBlocks() - 1); }
+
+	//The block's quads are body[first(b)] to body[end(b) - 1]
+	size_t first(BlockID block) const { return blockStart[block]; }
+	size_t end(BlockID block) const { return blockStart[block + 1]; }
+	BlockID blockOf(size_t quadIdx) const { return quadBlock[quadIdx]; }
+	//The block a jump to label lands in
+	BlockID blockOfLabel(LabelID label) const;
+
+	BlockRange succs(BlockID block) const{
+		return range(succList, succStart, block);
+	}
+	BlockRange preds(BlockID block) const{
+		return range(predList, predStart, block);
+	}
+
+	//The blocks reachable from entry, in reverse postorder
+	const std::vector<BlockID>& rpo() const { return myRPO; }
+	bool reachable(BlockID block) const {
+		return rpoIndex[block] != NO_BLOCK;
+	}
+	size_t numEdges() const { return succList.size(); }
+
+	//The dominator tree is only built on request. idom of the
+	// entry block (and of unreachable blocks) is NO_BLOCK.
+	void computeDominators();
+	bool hasDominators() const { return !idoms.empty(); }
+	BlockID idom(BlockID block) const { return idoms[block]; }
+	bool dominates(BlockID a, BlockID b) const;
+	BlockRange domChildren(BlockID block) const{
+		return range(domKids, domKidStart, block);
+	}
+
+	//Write the graph in graphviz DOT format, as a cluster
+	// named for the procedure (see writeDotFile)
+	void writeDot(std::ostream& out) const;
+private:
+	static BlockRange range(const std::vector<BlockID>& items,
+		const std::vector<uint32_t>& starts, BlockID block){
+		const BlockID * base = items.data();
+		return BlockRange(base + starts[block], base + starts[block + 1]);
+	}
+	void findBlocks();
+	void linkBlocks();
+	void orderBlocks();
+
+	Procedure * myProc;
+	//Index of each block's first quad, plus one past the end
+	std::vector<size_t> blockStart;
+	std::vector<BlockID> quadBlock;
+	HashMap<LabelID, BlockID> labelBlocks;
+
+	std::vector<uint32_t> succStart;
+	std::vector<BlockID> succList;
+	std::vector<uint32_t> predStart;
+	std::vector<BlockID> predList;
+
+	std::vector<BlockID> myRPO;
+	std::vector<BlockID> rpoIndex;
+
+	std::vector<BlockID> idoms;
+	std::vector<uint32_t> domKidStart;
+	std::vector<BlockID> domKids;
+	//Preorder entry and exit numbers in the dominator tree,
+	// so dominates() is two comparisons
+	std::vector<uint32_t> domPre;
+	std::vector<uint32_t> domPost;
+};
+
+//Write the CFG of every procedure in prog to out as one DOT
+// digraph
+void writeDotFile(IRProgram * prog, std::ostream& out);
+
+}
+
+#endif
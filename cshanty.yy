@@ -31,6 +31,7 @@
 
 %parse-param { cshanty::Scanner &scanner }
 %parse-param { cshanty::ProgramNode** root }
+%parse-param { cshanty::Arena &arena }
 %code{
    // C std code for utility functions
    #include <iostream>
@@ -49,31 +50,31 @@
 }
 
 %union {
-   bool                                  transBool;
-   cshanty::Token*                         transToken;
-   cshanty::Token*                         lexeme;
-   cshanty::IDToken*                       transIDToken;
-   cshanty::IntLitToken*                   transIntToken;
-   cshanty::StrToken*                      transStrToken;
-   cshanty::ProgramNode*                   transProgram;
-   cshanty::DeclNode *                     transDecl;
-   std::list<cshanty::DeclNode *> *        transDeclList;
-   cshanty::RecordTypeDeclNode *           transRecordDecl;
-   cshanty::VarDeclNode *                  transVarDecl;
-   std::list<cshanty::VarDeclNode *> *     transVarDeclList;
-   cshanty::FormalDeclNode *               transFormal;
-   std::list<cshanty::FormalDeclNode *> *  transFormalList;
-   cshanty::TypeNode *                     transType;
-   cshanty::LValNode *                     transLVal;
-   cshanty::IDNode *                       transID;
-   cshanty::FnDeclNode *                   transFn;
-   std::list<cshanty::VarDeclNode *> *     transVarDecls;
-   std::list<cshanty::StmtNode *> *        transStmts;
-   cshanty::StmtNode *                     transStmt;
-   cshanty::ExpNode *                      transExp;
-   cshanty::AssignExpNode *                transAssignExp;
-   cshanty::CallExpNode *                  transCallExp;
-   std::list<cshanty::ExpNode *> *         transActuals;
+   bool                                            transBool;
+   cshanty::Token*                                 transToken;
+   cshanty::Token*                                 lexeme;
+   cshanty::IDToken*                               transIDToken;
+   cshanty::IntLitToken*                           transIntToken;
+   cshanty::StrToken*                              transStrToken;
+   cshanty::ProgramNode*                           transProgram;
+   cshanty::DeclNode *                             transDecl;
+   cshanty::NodeList<cshanty::DeclNode *> *        transDeclList;
+   cshanty::RecordTypeDeclNode *                   transRecordDecl;
+   cshanty::VarDeclNode *                          transVarDecl;
+   cshanty::NodeList<cshanty::VarDeclNode *> *     transVarDeclList;
+   cshanty::FormalDeclNode *                       transFormal;
+   cshanty::NodeList<cshanty::FormalDeclNode *> *  transFormalList;
+   cshanty::TypeNode *                             transType;
+   cshanty::LValNode *                             transLVal;
+   cshanty::IDNode *                               transID;
+   cshanty::FnDeclNode *                           transFn;
+   cshanty::NodeList<cshanty::VarDeclNode *> *     transVarDecls;
+   cshanty::NodeList<cshanty::StmtNode *> *        transStmts;
+   cshanty::StmtNode *                             transStmt;
+   cshanty::ExpNode *                              transExp;
+   cshanty::AssignExpNode *                        transAssignExp;
+   cshanty::CallExpNode *                          transCallExp;
+   cshanty::NodeList<cshanty::ExpNode *> *         transActuals;
 }
 
 %define parse.assert
@@ -156,7 +157,7 @@
 
 program 	: globals
 		  {
-		  $$ = new ProgramNode($1);
+		  $$ = arena.make<ProgramNode>(Position(), $1);
 		  *root = $$;
 		  }
 
@@ -168,7 +169,7 @@ globals 	: globals decl
 	  	  }
 		| /* epsilon */
 		  {
-		  $$ = new std::list<DeclNode * >();
+		  $$ = makeNodeList<DeclNode *>(arena);
 		  }
 
 decl 		: varDecl
@@ -180,19 +181,19 @@ decl 		: varDecl
 
 recordDecl	: RECORD id OPEN varDeclList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $5->pos());
-		  $$ = new RecordTypeDeclNode(p, $2, $4);
+		  Position p($1->pos(), $5->pos());
+		  $$ = arena.make<RecordTypeDeclNode>(p, $2, $4);
 		  }
 
 varDecl 	: type id SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new VarDeclNode(p, $1, $2);
+		  Position p($1->pos(), $2->pos());
+		  $$ = arena.make<VarDeclNode>(p, $1, $2);
 		  }
 
 varDeclList     : varDecl
 		  {
-		  $$ = new std::list<VarDeclNode *>();
+		  $$ = makeNodeList<VarDeclNode *>(arena);
 		  $$->push_back($1);
 		  }
 		| varDeclList varDecl
@@ -203,40 +204,40 @@ varDeclList     : varDecl
 
 type 		: INT
 	  	  { 
-		  $$ = new IntTypeNode($1->pos());
+		  $$ = arena.make<IntTypeNode>($1->pos());
 		  }
 		| BOOL
 		  {
-		  $$ = new BoolTypeNode($1->pos());
+		  $$ = arena.make<BoolTypeNode>($1->pos());
 		  }
 		| id
 		  {
-		  $$ = new RecordTypeNode($1->pos(), $1);
+		  $$ = arena.make<RecordTypeNode>($1->pos(), $1);
 		  }
 		| STRING
 		  {
-		  $$ = new StringTypeNode($1->pos());
+		  $$ = arena.make<StringTypeNode>($1->pos());
 		  }
 		| VOID
 		  {
-		  $$ = new VoidTypeNode($1->pos());
+		  $$ = arena.make<VoidTypeNode>($1->pos());
 		  }
 
 fnDecl 		: type id LPAREN RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * pos = new Position($1->pos(), $7->pos());
-		  std::list<FormalDeclNode *> * f = new std::list<FormalDeclNode *>();
-		  $$ = new FnDeclNode(pos, $1, $2, f, $6);
+		  Position pos($1->pos(), $7->pos());
+		  NodeList<FormalDeclNode *> * f = makeNodeList<FormalDeclNode *>(arena);
+		  $$ = arena.make<FnDeclNode>(pos, $1, $2, f, $6);
 		  }
 		| type id LPAREN formals RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * pos = new Position($1->pos(), $8->pos());
-		  $$ = new FnDeclNode(pos, $1, $2, $4, $7);
+		  Position pos($1->pos(), $8->pos());
+		  $$ = arena.make<FnDeclNode>(pos, $1, $2, $4, $7);
 		  }
 
 formals 	: formalDecl
 		  {
-		  $$ = new std::list<FormalDeclNode *>();
+		  $$ = makeNodeList<FormalDeclNode *>(arena);
 		  $$->push_back($1);
 		  }
 		| formals COMMA formalDecl
@@ -260,13 +261,13 @@ formals 	: formalDecl
 
 formalDecl 	: type id
 		  {
-		  Position * pos = new Position($1->pos(), $2->pos());
-		  $$ = new FormalDeclNode(pos, $1, $2);
+		  Position pos($1->pos(), $2->pos());
+		  $$ = arena.make<FormalDeclNode>(pos, $1, $2);
 		  }
 
 stmtList 	: /* epsilon */
 	   	  {
-		  $$ = new std::list<StmtNode *>();
+		  $$ = makeNodeList<StmtNode *>(arena);
 		  //$$->push_back($1);
 	   	  }
 		| stmtList stmt
@@ -277,163 +278,163 @@ stmtList 	: /* epsilon */
 
 stmt		: varDecl
 		  {
-		  Position * p = $1->pos();
-		  $$ = new VarDeclNode(p, $1->getTypeNode(), $1->ID());
+		  Position p = $1->pos();
+		  $$ = arena.make<VarDeclNode>(p, $1->getTypeNode(), $1->ID());
 		  }
 		| assignExp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new AssignStmtNode(p, $1); 
+		  Position p($1->pos(), $2->pos());
+		  $$ = arena.make<AssignStmtNode>(p, $1); 
 		  }
 		| lval DEC SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PostDecStmtNode(p, $1);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<PostDecStmtNode>(p, $1);
 		  }
 		| lval INC SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PostIncStmtNode(p, $1);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<PostIncStmtNode>(p, $1);
 		  }
 		| RECEIVE lval SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReceiveStmtNode(p, $2);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<ReceiveStmtNode>(p, $2);
 		  }
 		| REPORT exp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReportStmtNode(p, $2);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<ReportStmtNode>(p, $2);
 		  }
 		| IF LPAREN exp RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $7->pos());
-		  $$ = new IfStmtNode(p, $3, $6);
+		  Position p($1->pos(), $7->pos());
+		  $$ = arena.make<IfStmtNode>(p, $3, $6);
 		  }
 		| IF LPAREN exp RPAREN OPEN stmtList CLOSE ELSE OPEN stmtList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $11->pos());
-		  $$ = new IfElseStmtNode(p, $3, $6, $10);
+		  Position p($1->pos(), $11->pos());
+		  $$ = arena.make<IfElseStmtNode>(p, $3, $6, $10);
 		  }
 		| WHILE LPAREN exp RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $7->pos());
-		  $$ = new WhileStmtNode(p, $3, $6);
+		  Position p($1->pos(), $7->pos());
+		  $$ = arena.make<WhileStmtNode>(p, $3, $6);
 		  }
 		| RETURN exp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReturnStmtNode(p, $2);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<ReturnStmtNode>(p, $2);
 		  }
 		| RETURN SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new ReturnStmtNode(p, nullptr);
+		  Position p($1->pos(), $2->pos());
+		  $$ = arena.make<ReturnStmtNode>(p, nullptr);
 		  }
 		| callExp SEMICOL
 		  { 
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new CallStmtNode(p, $1); 
+		  Position p($1->pos(), $2->pos());
+		  $$ = arena.make<CallStmtNode>(p, $1); 
 		  }
 
 exp		: assignExp 
 		  { $$ = $1; } 
 		| exp MINUS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new MinusNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<MinusNode>(p, $1, $3);
 		  }
 		| exp PLUS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PlusNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<PlusNode>(p, $1, $3);
 		  }
 		| exp TIMES exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new TimesNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<TimesNode>(p, $1, $3);
 		  }
 		| exp DIVIDE exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new DivideNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<DivideNode>(p, $1, $3);
 		  }
 		| exp AND exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new AndNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<AndNode>(p, $1, $3);
 		  }
 		| exp OR exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new OrNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<OrNode>(p, $1, $3);
 		  }
 		| exp EQUALS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new EqualsNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<EqualsNode>(p, $1, $3);
 		  }
 		| exp NOTEQUALS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new NotEqualsNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<NotEqualsNode>(p, $1, $3);
 		  }
 		| exp GREATER exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new GreaterNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<GreaterNode>(p, $1, $3);
 		  }
 		| exp GREATEREQ exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new GreaterEqNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<GreaterEqNode>(p, $1, $3);
 		  }
 		| exp LESS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new LessNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<LessNode>(p, $1, $3);
 		  }
 		| exp LESSEQ exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new LessEqNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<LessEqNode>(p, $1, $3);
 		  }
 		| NOT exp
 	  	  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new NotNode(p, $2);
+		  Position p($1->pos(), $2->pos());
+		  $$ = arena.make<NotNode>(p, $2);
 		  }
 		| MINUS term
 	  	  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new NegNode(p, $2);
+		  Position p($1->pos(), $2->pos());
+		  $$ = arena.make<NegNode>(p, $2);
 		  }
 		| term 
 	  	  { $$ = $1; }
 
 assignExp	: lval ASSIGN exp
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new AssignExpNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = arena.make<AssignExpNode>(p, $1, $3);
 		  }
 
 callExp		: id LPAREN RPAREN
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  std::list<ExpNode *> * noargs =
-		    new std::list<ExpNode *>();
-		  $$ = new CallExpNode(p, $1, noargs);
+		  Position p($1->pos(), $3->pos());
+		  NodeList<ExpNode *> * noargs =
+		    makeNodeList<ExpNode *>(arena);
+		  $$ = arena.make<CallExpNode>(p, $1, noargs);
 		  }
 		| id LPAREN actualsList RPAREN
 		  {
-		  Position * p = new Position($1->pos(), $4->pos());
-		  $$ = new CallExpNode(p, $1, $3);
+		  Position p($1->pos(), $4->pos());
+		  $$ = arena.make<CallExpNode>(p, $1, $3);
 		  }
 
 actualsList	: exp
 		  {
-		  std::list<ExpNode *> * list =
-		    new std::list<ExpNode *>();
+		  NodeList<ExpNode *> * list =
+		    makeNodeList<ExpNode *>(arena);
 		  list->push_back($1);
 		  $$ = list;
 		  }
@@ -446,13 +447,13 @@ actualsList	: exp
 term 		: lval
 		  { $$ = $1; }
 		| INTLITERAL 
-		  { $$ = new IntLitNode($1->pos(), $1->num()); }
+		  { $$ = arena.make<IntLitNode>($1->pos(), $1->num()); }
 		| STRLITERAL 
-		  { $$ = new StrLitNode($1->pos(), $1->str()); }
+		  { $$ = arena.make<StrLitNode>($1->pos(), $1->str()); }
 		| TRUE
-		  { $$ = new TrueNode($1->pos()); }
+		  { $$ = arena.make<TrueNode>($1->pos()); }
 		| FALSE
-		  { $$ = new FalseNode($1->pos()); }
+		  { $$ = arena.make<FalseNode>($1->pos()); }
 		| LPAREN exp RPAREN
 		  { $$ = $2; }
 		| callExp
@@ -466,19 +467,19 @@ lval		: id
 		  }
 		| id LBRACE id RBRACE
 		  {
-		  Position * pos = new Position($1->pos(), $4->pos());
-		  $$ = new IndexNode(pos, $1, $3);
+		  Position pos($1->pos(), $4->pos());
+		  $$ = arena.make<IndexNode>(pos, $1, $3);
 		  }
 
 id		: ID
 		  {
-		  Position * pos = $1->pos();
-		  $$ = new IDNode(pos, $1->value()); 
+		  Position pos = $1->pos();
+		  $$ = arena.make<IDNode>(pos, $1->value()); 
 		  }
 	
 %%
 
 void cshanty::Parser::error(const std::string& msg){
-	std::cout << msg << std::endl;
-	std::cerr << "syntax error" << std::endl;
+	cshanty::Report::out() << msg << std::endl;
+	cshanty::Report::err() << "syntax error" << std::endl;
 }
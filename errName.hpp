@@ -7,15 +7,15 @@ namespace cshanty{
 
 class NameErr{
 public:
-static bool undeclID(Position * pos){
+static bool undeclID(Position pos){
 	Report::fatal(pos, "Undeclared identifier");
 	return false;
 }
-static bool badVarType(Position * pos){
+static bool badVarType(Position pos){
 	Report::fatal(pos, "Invalid type in declaration");
 	return false;
 }
-static bool multiDecl(Position * pos){
+static bool multiDecl(Position pos){
 	Report::fatal(pos, "Multiply declared identifier");
 	return false;
 }
@@ -29,39 +29,62 @@ private:
 
 class Report{
 public:
+	//Diagnostics normally go to std::cerr (and parser 
+	// messages to std::cout). A thread can redirect both into
+	// a stream of its own, e.g. to keep the messages of one
+	// compilation together when several run at once.
+	static void redirect(std::ostream * stream){
+		sink() = stream;
+	}
+	//The thread's current redirection, or null
+	static std::ostream * redirection(){
+		return sink();
+	}
+	static std::ostream& err(){
+		return sink() ? *sink() : std::cerr;
+	}
+	static std::ostream& out(){
+		return sink() ? *sink() : std::cout;
+	}
+
 	static void fatal(
-		Position * pos,
+		Position pos,
 		const char * msg
 	){
-		std::cerr << "FATAL " 
-		<< pos->span()
+		err() << "FATAL " 
+		<< pos.span()
 		<< ": " 
 		<< msg  << std::endl;
 	}
 
 	static void fatal(
-		Position * pos,
+		Position pos,
 		const std::string msg
 	){
 		fatal(pos,msg.c_str());
 	}
 
 	static void warn(
-		Position * pos,
+		Position pos,
 		const char * msg
 	){
-		std::cerr << "WARNING "
-		<< pos->span()
+		err() << "WARNING "
+		<< pos.span()
 		<< " " 
 		<< msg  << std::endl;
 	}
 
 	static void warn(
-		Position * pos,
+		Position pos,
 		const std::string msg
 	){
 		warn(pos,msg.c_str());
 	}
+private:
+	static std::ostream *& sink(){
+		static thread_local std::ostream * stream = nullptr;
+		return stream;
+	}
 };
 
 }
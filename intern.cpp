@@ -0,0 +1,56 @@
+#include <cstring>
+#include "intern.hpp"
+
+namespace cshanty{
+
+static uint32_t hashText(const char * text, size_t len){
+	//FNV-1a
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < len; i++){
+		h ^= static_cast<unsigned char>(text[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+Interner::Interner() : slots(256, 0){
+}
+
+Ident Interner::intern(const char * text, size_t len){
+	uint32_t h = hashText(text, len);
+	size_t mask = slots.size() - 1;
+	size_t idx = h & mask;
+	while (slots[idx] != 0){
+		const Ident::Entry& entry = entries[slots[idx] - 1];
+		if (entry.hash == h && entry.text.length() == len
+		  && memcmp(entry.text.data(), text, len) == 0){
+			return Ident(&entry);
+		}
+		idx = (idx + 1) & mask;
+	}
+
+	uint32_t id = static_cast<uint32_t>(entries.size());
+	Ident::Entry fresh;
+	fresh.text.assign(text, len);
+	fresh.id = id;
+	fresh.hash = h;
+	entries.push_back(fresh);
+	slots[idx] = id + 1;
+
+	//Keep the load factor at or below one half
+	if (entries.size() * 2 > slots.size()){ grow(); }
+	return Ident(&entries.back());
+}
+
+void Interner::grow(){
+	std::vector<uint32_t> bigger(slots.size() * 2, 0);
+	size_t mask = bigger.size() - 1;
+	for (const Ident::Entry& entry : entries){
+		size_t idx = entry.hash & mask;
+		while (bigger[idx] != 0){ idx = (idx + 1) & mask; }
+		bigger[idx] = entry.id + 1;
+	}
+	slots.swap(bigger);
+}
+
+}
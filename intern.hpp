@@ -0,0 +1,73 @@
+#ifndef CSHANTY_INTERN_HPP
+#define CSHANTY_INTERN_HPP
+
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace cshanty{
+
+//A handle to an interned identifier. Every occurrence of
+// the same spelling in a compilation shares one Ident, so
+// identifiers are compared by pointer and hashed by their
+// small integer id rather than by their characters.
+class Ident{
+public:
+	struct Entry{
+		std::string text;
+		uint32_t id;
+		uint32_t hash;
+	};
+
+	Ident() : myEntry(nullptr){ }
+	explicit Ident(const Entry * entryIn) : myEntry(entryIn){ }
+	//Dense, starting from 0 in each Interner
+	uint32_t id() const { return myEntry->id; }
+	const std::string& str() const { return myEntry->text; }
+	bool isNull() const { return myEntry == nullptr; }
+	bool operator==(Ident other) const { return myEntry == other.myEntry; }
+	bool operator!=(Ident other) const { return myEntry != other.myEntry; }
+private:
+	const Entry * myEntry;
+};
+
+inline std::ostream& operator<<(std::ostream& out, Ident ident){
+	return out << ident.str();
+}
+
+//The string table for one compilation. The scanner interns
+// every identifier it sees; later phases only ever handle
+// the resulting Idents.
+class Interner{
+public:
+	Interner();
+	Ident intern(const char * text, size_t len);
+	Ident intern(const std::string& text){
+		return intern(text.data(), text.length());
+	}
+	//The number of distinct identifiers seen so far
+	size_t size() const { return entries.size(); }
+private:
+	void grow();
+
+	//Entries never move once created, so Idents stay valid
+	std::deque<Ident::Entry> entries;
+	//Open-addressed table of entry index + 1 (0 is empty)
+	std::vector<uint32_t> slots;
+};
+
+}
+
+namespace std{
+template <>
+struct hash<cshanty::Ident>{
+	size_t operator()(cshanty::Ident ident) const{
+		return ident.id();
+	}
+};
+}
+
+#endif
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <limits>
+#include <signal.h>
+#include <stdlib.h>
+#include <string>
+#include "interp.hpp"
+#include "runtime.hpp"
+
+namespace cshanty{
+
+//The return value register, in the statics
+static const uint32_t RET_STATIC = 0;
+static const uint32_t NO_REF = UINT32_MAX;
+//Value stack slots (8 MB)
+static const size_t STACK_SLOTS = 1 << 20;
+
+Interpreter::Interpreter(IRProgram * prog) : mainIdx(UINT32_MAX){
+	statics.push_back(0);
+	//Strings are kept unescaped, ready to print; the vector
+	// is filled before any address is taken from it
+	for (size_t i = 0; i < prog->getStrings().size(); i++){
+		stringVals.push_back(prog->stringValue(static_cast<uint32_t>(i)));
+	}
+	for (const std::string& val : stringVals){
+		stringRefs.push_back(addStatic(reinterpret_cast<int64_t>(val.c_str())));
+	}
+	for (SemSymbol * global : prog->getGlobals()){
+		globalRefs[global] = addStatic(0);
+	}
+
+	uint32_t idx = 0;
+	for (Procedure * proc : *prog->getProcs()){
+		procIdx[proc->getName()] = idx++;
+	}
+	procs.resize(idx);
+	idx = 0;
+	for (Procedure * proc : *prog->getProcs()){
+		decode(proc, idx++);
+	}
+	auto main = procIdx.find("main");
+	if (main == procIdx.end()){
+		throw new InternalError("No main function to run");
+	}
+	mainIdx = main->second;
+}
+
+uint32_t Interpreter::addStatic(int64_t val){
+	statics.push_back(val);
+	return staticRef(static_cast<uint32_t>(statics.size() - 1));
+}
+
+void Interpreter::decode(Procedure * proc, uint32_t idx){
+	std::vector<Quad>& body = proc->getBody();
+
+	//The arguments come first in the frame, then a slot for
+	// every other operand that isn't a static
+	uint32_t numArgs = static_cast<uint32_t>(proc->getFormals().size());
+	uint32_t outArgs = 0;
+	for (const Quad& quad : body){
+		uint32_t argIdx = static_cast<uint32_t>(quad.getIndex());
+		if (quad.getOp() == QuadOp::GETARG){
+			numArgs = std::max(numArgs, argIdx);
+		} else if (quad.getOp() == QuadOp::SETARG){
+			outArgs = std::max(outArgs, argIdx);
+		}
+	}
+	uint32_t numSlots = numArgs;
+	std::vector<uint32_t> refs(proc->numOpds(), NO_REF);
+	auto ref = [&](OpdID opdID){
+		if (refs[opdID] != NO_REF){ return refs[opdID]; }
+		const Opd& opd = proc->getOpd(opdID);
+		uint32_t res;
+		if (opd.getKind() == OpdKind::LIT){
+			auto found = constRefs.find(opd.getValue());
+			if (found == constRefs.end()){
+				res = addStatic(opd.getValue());
+				constRefs[opd.getValue()] = res;
+			} else {
+				res = found->second;
+			}
+		} else if (opd.getKind() == OpdKind::STR){
+			res = stringRefs[opd.getNum()];
+		} else if (opd.getKind() == OpdKind::SYM
+		  && proc->getProg()->isGlobal(opd.getSym())){
+			res = globalRefs[opd.getSym()];
+		} else {
+			res = frameRef(numSlots++);
+		}
+		refs[opdID] = res;
+		return res;
+	};
+	for (const Quad& quad : body){
+		if (quad.getOp() == QuadOp::PHI){
+			throw new InternalError("Can't interpret SSA form");
+		}
+		if (quad.getOp() == QuadOp::INDEX){
+			throw new ToDoError("Record fields can't be interpreted");
+		}
+		if (quad.getDst() != NO_OPD){ ref(quad.getDst()); }
+		if (quad.getSrc1() != NO_OPD && quad.getOp() != QuadOp::CALL){
+			ref(quad.getSrc1());
+		}
+		if (quad.getSrc2() != NO_OPD){ ref(quad.getSrc2()); }
+	}
+
+	ProcInfo& info = procs[idx];
+	info.entry = static_cast<uint32_t>(code.size());
+	info.frameSize = numSlots;
+	info.extent = numSlots + outArgs;
+
+	HashMap<LabelID, uint32_t> labelAt;
+	std::vector<std::pair<size_t, LabelID>> fixups;
+	auto emit = [&](Op op, uint32_t dst, uint32_t a, uint32_t b){
+		Instr instr;
+		instr.handler = nullptr;
+		instr.op = op;
+		instr.dst = dst;
+		instr.a = a;
+		instr.b = b;
+		instr.aux = 0;
+		code.push_back(instr);
+	};
+	auto jump = [&](Op op, uint32_t cond, LabelID target){
+		fixups.emplace_back(code.size(), target);
+		emit(op, NO_REF, cond, NO_REF);
+	};
+	bool returns = false;
+	for (const Quad& quad : body){
+		if (quad.getLabel() != NO_LABEL){
+			labelAt[quad.getLabel()] = static_cast<uint32_t>(code.size());
+		}
+		OpdID dst = quad.getDst();
+		OpdID src = quad.getSrc1();
+		switch (quad.getOp()){
+		case QuadOp::ASSIGN:
+			emit(Op::MOV, refs[dst], refs[src], NO_REF);
+			break;
+		case QuadOp::BINOP: {
+			Op op = Op::ADD;
+			switch (quad.getBinOp()){
+			case ADD64: op = Op::ADD; break;
+			case SUB64: op = Op::SUB; break;
+			case MULT64: op = Op::MULT; break;
+			case DIV64: op = Op::DIV; break;
+			case AND64: op = Op::AND; break;
+			case OR64: op = Op::OR; break;
+			case EQ64: op = Op::EQ; break;
+			case NEQ64: op = Op::NEQ; break;
+			case LT64: op = Op::LT; break;
+			case GT64: op = Op::GT; break;
+			case LTE64: op = Op::LTE; break;
+			case GTE64: op = Op::GTE; break;
+			}
+			emit(op, refs[dst], refs[src], refs[quad.getSrc2()]);
+			break;
+		}
+		case QuadOp::UNARYOP:
+			emit(quad.getUnaryOp() == NEG64 ? Op::NEG : Op::NOT,
+				refs[dst], refs[src], NO_REF);
+			break;
+		case QuadOp::GOTO:
+			jump(Op::JMP, NO_REF, quad.getTarget());
+			break;
+		case QuadOp::IFZ:
+			jump(Op::JZ, refs[src], quad.getTarget());
+			break;
+		case QuadOp::REPORT: {
+			const DataType * type = quad.getType();
+			Op op = type->isBool() ? Op::PRINT_BOOL
+				: type->isString() ? Op::PRINT_STR : Op::PRINT_INT;
+			emit(op, NO_REF, refs[src], NO_REF);
+			break;
+		}
+		case QuadOp::RECEIVE:
+			emit(quad.getType()->isBool() ? Op::READ_BOOL : Op::READ_INT,
+				refs[dst], NO_REF, NO_REF);
+			break;
+		case QuadOp::CALL: {
+			SemSymbol * fn = proc->getOpd(src).getSym();
+			auto callee = procIdx.find(fn->getName());
+			if (callee == procIdx.end()){
+				throw new InternalError("Call to a function with no body");
+			}
+			emit(Op::CALL, NO_REF, NO_REF, numSlots);
+			code.back().aux = callee->second;
+			break;
+		}
+		case QuadOp::SETARG: {
+			uint32_t slot = numSlots + static_cast<uint32_t>(quad.getIndex()) - 1;
+			emit(Op::MOV, frameRef(slot), refs[src], NO_REF);
+			break;
+		}
+		case QuadOp::GETARG: {
+			uint32_t slot = static_cast<uint32_t>(quad.getIndex()) - 1;
+			emit(Op::MOV, refs[dst], frameRef(slot), NO_REF);
+			break;
+		}
+		case QuadOp::SETRET:
+			emit(Op::MOV, staticRef(RET_STATIC), refs[src], NO_REF);
+			returns = true;
+			break;
+		case QuadOp::GETRET:
+			emit(Op::MOV, refs[dst], staticRef(RET_STATIC), NO_REF);
+			break;
+		case QuadOp::NOP:
+		case QuadOp::ENTER:
+		case QuadOp::LEAVE:
+			break;
+		case QuadOp::INDEX:
+		case QuadOp::PHI:
+			throw new InternalError("Quad can't be interpreted");
+		}
+	}
+	labelAt[proc->getLeaveLabel()] = static_cast<uint32_t>(code.size());
+	//A main with no return value gives 0, as lowerX64 has it
+	if (proc->getName() == "main" && !returns){
+		uint32_t zero = constRefs.count(0) ? constRefs[0] : addStatic(0);
+		constRefs[0] = zero;
+		emit(Op::MOV, staticRef(RET_STATIC), zero, NO_REF);
+	}
+	emit(Op::RET, NO_REF, NO_REF, NO_REF);
+
+	for (const auto& fixup : fixups){
+		auto target = labelAt.find(fixup.second);
+		if (target == labelAt.end()){
+			throw new InternalError("Jump to a label not in the procedure");
+		}
+		code[fixup.first].aux = target->second;
+	}
+}
+
+//Arithmetic wraps, as it does in the machine
+static int64_t wrap(uint64_t val){ return static_cast<int64_t>(val); }
+static uint64_t bits(int64_t val){ return static_cast<uint64_t>(val); }
+
+//Computed gotos are a GNU extension
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+int64_t Interpreter::run(std::istream& in, std::ostream& out){
+	static const void * const handlers[] = {
+		&&do_MOV, &&do_ADD, &&do_SUB, &&do_MULT, &&do_DIV, &&do_AND,
+		&&do_OR, &&do_EQ, &&do_NEQ, &&do_LT, &&do_GT, &&do_LTE,
+		&&do_GTE, &&do_NEG, &&do_NOT, &&do_JMP, &&do_JZ,
+		&&do_PRINT_INT, &&do_PRINT_BOOL, &&do_PRINT_STR,
+		&&do_READ_INT, &&do_READ_BOOL, &&do_CALL, &&do_RET
+	};
+	static_assert(sizeof(handlers) / sizeof(handlers[0])
+		== static_cast<size_t>(Op::RET) + 1, "A handler for each Op");
+	for (Instr& instr : code){
+		instr.handler = handlers[static_cast<size_t>(instr.op)];
+	}
+
+	std::vector<int64_t> live = statics;
+	stack.assign(STACK_SLOTS, 0);
+	int64_t * const stackEnd = stack.data() + stack.size();
+	//Where each running call returns to, and its caller's frame
+	std::vector<std::pair<const Instr *, int64_t *>> calls;
+
+	//An operand is found through bases[0] (the frame) or
+	// bases[1] (the statics) by its low bit
+	int64_t * bases[2] = { stack.data(), live.data() };
+	#define VAL(ref) bases[(ref) & 1][(ref) >> 1]
+	#define NEXT() do { pc++; goto *pc->handler; } while (0)
+	#define BINARY(op, expr) do_##op: { \
+		int64_t x = VAL(pc->a); \
+		int64_t y = VAL(pc->b); \
+		VAL(pc->dst) = (expr); \
+		NEXT(); \
+	}
+
+	const ProcInfo& main = procs[mainIdx];
+	if (main.extent > STACK_SLOTS){
+		throw new InternalError("Interpreted program ran out of stack");
+	}
+	const Instr * pc = code.data() + main.entry;
+	goto *pc->handler;
+
+do_MOV:
+	VAL(pc->dst) = VAL(pc->a);
+	NEXT();
+BINARY(ADD, wrap(bits(x) + bits(y)))
+BINARY(SUB, wrap(bits(x) - bits(y)))
+BINARY(MULT, wrap(bits(x) * bits(y)))
+do_DIV: {
+	int64_t x = VAL(pc->a);
+	int64_t y = VAL(pc->b);
+	//The quotients idiv traps on, in the -o and --jit code;
+	// the program dies of SIGFPE here too
+	if (y == 0 || (y == -1 && x == std::numeric_limits<int64_t>::min())){
+		raise(SIGFPE);
+		//Only reached if SIGFPE is ignored
+		abort();
+	}
+	VAL(pc->dst) = x / y;
+	NEXT();
+}
+BINARY(AND, x & y)
+BINARY(OR, x | y)
+BINARY(EQ, x == y)
+BINARY(NEQ, x != y)
+BINARY(LT, x < y)
+BINARY(GT, x > y)
+BINARY(LTE, x <= y)
+BINARY(GTE, x >= y)
+do_NEG:
+	VAL(pc->dst) = wrap(0 - bits(VAL(pc->a)));
+	NEXT();
+do_NOT:
+	VAL(pc->dst) = VAL(pc->a) ^ 1;
+	NEXT();
+do_JMP:
+	pc = code.data() + pc->aux;
+	goto *pc->handler;
+do_JZ:
+	if (VAL(pc->a) == 0){
+		pc = code.data() + pc->aux;
+		goto *pc->handler;
+	}
+	NEXT();
+do_PRINT_INT:
+	out << VAL(pc->a);
+	NEXT();
+do_PRINT_BOOL:
+	out << (VAL(pc->a) ? "true" : "false");
+	NEXT();
+do_PRINT_STR:
+	out << reinterpret_cast<const char *>(VAL(pc->a));
+	NEXT();
+do_READ_INT:
+	VAL(pc->dst) = receiveInt(in, out);
+	NEXT();
+do_READ_BOOL:
+	VAL(pc->dst) = receiveBool(in, out);
+	NEXT();
+do_CALL: {
+	const ProcInfo& callee = procs[pc->aux];
+	//The callee's frame starts where the SETARGs wrote, just
+	// past the caller's
+	int64_t * frame = bases[0];
+	int64_t * next = frame + pc->b;
+	if (next + callee.extent > stackEnd){
+		throw new InternalError("Interpreted program ran out of stack");
+	}
+	calls.emplace_back(pc + 1, frame);
+	bases[0] = next;
+	pc = code.data() + callee.entry;
+	goto *pc->handler;
+}
+do_RET:
+	if (calls.empty()){ return live[RET_STATIC]; }
+	pc = calls.back().first;
+	bases[0] = calls.back().second;
+	calls.pop_back();
+	goto *pc->handler;
+	#undef VAL
+	#undef NEXT
+	#undef BINARY
+}
+
+#pragma GCC diagnostic pop
+
+}
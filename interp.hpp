@@ -0,0 +1,85 @@
+#ifndef CSHANTY_INTERP_HPP
+#define CSHANTY_INTERP_HPP
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//An interpreter for 3AC, to run a program straight from its
+// IRProgram without assembling it. The program is decoded
+// once into a flat array of instructions: operands become
+// indices into the running procedure's frame or into the
+// program's statics (constants, globals, string addresses
+// and the return value), and labels become instruction
+// indices. Instructions are then dispatched by jumping
+// straight to each one's handler (direct threading, with
+// GNU computed gotos).
+//
+//Frames live on one value stack. A frame holds a
+// procedure's arguments, then a slot for each of its
+// variables, so SETARG can write straight into the frame the
+// callee is about to get and GETARG is a plain copy. The
+// program runs as its x64 lowering would (see
+// x64_codegen.cpp): arithmetic wraps, REPORT and RECEIVE
+// behave like the runtime in stdcshanty.c, and main's result
+// is 0 if it returns nothing. A division idiv would trap on
+// (by zero, or of INT64_MIN by -1) raises SIGFPE, killing
+// the compiler just as it kills a compiled program.
+class Interpreter{
+public:
+	//Decode prog, which must be out of SSA form. It may have
+	// been optimized or register allocated.
+	explicit Interpreter(IRProgram * prog);
+	//Run main, reading input from in and writing output to
+	// out, and return its result
+	int64_t run(std::istream& in, std::ostream& out);
+	size_t numInstrs() const { return code.size(); }
+private:
+	enum class Op : uint8_t{
+		MOV, ADD, SUB, MULT, DIV, AND, OR, EQ, NEQ, LT, GT, LTE, GTE,
+		NEG, NOT, JMP, JZ, PRINT_INT, PRINT_BOOL, PRINT_STR,
+		READ_INT, READ_BOOL, CALL, RET
+	};
+	//One decoded quad. dst, a and b are operand references
+	// (see ref()); aux is a jump target, or a callee's index
+	// into procs.
+	struct Instr{
+		const void * handler;
+		Op op;
+		uint32_t dst;
+		uint32_t a;
+		uint32_t b;
+		uint32_t aux;
+	};
+	struct ProcInfo{
+		uint32_t entry;
+		//Slots in the frame, and in it plus the outgoing
+		// arguments of its calls
+		uint32_t frameSize;
+		uint32_t extent;
+	};
+
+	void decode(Procedure * proc, uint32_t idx);
+	uint32_t addStatic(int64_t val);
+	static uint32_t frameRef(uint32_t slot){ return slot << 1; }
+	static uint32_t staticRef(uint32_t idx){ return idx << 1 | 1; }
+
+	std::vector<Instr> code;
+	std::vector<ProcInfo> procs;
+	HashMap<std::string, uint32_t> procIdx;
+	uint32_t mainIdx;
+	//Statics as they are before the program runs
+	std::vector<int64_t> statics;
+	HashMap<int64_t, uint32_t> constRefs;
+	HashMap<SemSymbol *, uint32_t> globalRefs;
+	std::vector<uint32_t> stringRefs;
+	std::vector<std::string> stringVals;
+	std::vector<int64_t> stack;
+};
+
+}
+
+#endif
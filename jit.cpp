@@ -0,0 +1,390 @@
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "jit.hpp"
+#include "runtime.hpp"
+#include "x64.hpp"
+
+namespace cshanty{
+
+static uint8_t num(Reg reg){ return static_cast<uint8_t>(reg); }
+
+//Machine code under construction, with encoders for the few
+// instructions the lowering uses. Every operation is 64-bit
+// (REX.W); memory operands are %rbp- or %rsp-relative, or
+// %rip-relative for the data.
+class MachineCode{
+public:
+	explicit MachineCode(size_t dataSizeIn) : dataSize(dataSizeIn){ }
+	size_t size() const { return bytes.size(); }
+	const uint8_t * data() const { return bytes.data(); }
+
+	void byte(uint8_t b){ bytes.push_back(b); }
+	void bytes2(uint8_t a, uint8_t b){ byte(a); byte(b); }
+	void imm32(int64_t val){
+		uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(val));
+		for (int i = 0; i < 4; i++){
+			byte(static_cast<uint8_t>(bits >> (8 * i)));
+		}
+	}
+	void imm64(int64_t val){
+		uint64_t bits = static_cast<uint64_t>(val);
+		for (int i = 0; i < 8; i++){
+			byte(static_cast<uint8_t>(bits >> (8 * i)));
+		}
+	}
+
+	//op reg, rm or op rm, reg between registers (e.g. 0x89 is
+	// mov rm <- reg, 0x01 add, 0x29 sub, 0x39 cmp)
+	void regReg(uint8_t op, Reg reg, Reg rm){
+		rex(reg, rm);
+		byte(op);
+		byte(static_cast<uint8_t>(0xC0 | (num(reg) & 7) << 3 | (num(rm) & 7)));
+	}
+	//op between reg and disp(%rbp) (0x8B loads, 0x89 stores)
+	void regFrame(uint8_t op, Reg reg, int64_t disp){
+		rex(reg, Reg::RBP);
+		byte(op);
+		byte(static_cast<uint8_t>(0x80 | (num(reg) & 7) << 3 | 5));
+		imm32(disp);
+	}
+	//movq reg, disp(%rsp)
+	void storeStack(Reg reg, int64_t disp){
+		rex(reg, Reg::RSP);
+		byte(0x89);
+		byte(static_cast<uint8_t>(0x84 | (num(reg) & 7) << 3));
+		byte(0x24);
+		imm32(disp);
+	}
+	//op between reg and the data at dataOff (0x8B loads, 0x89
+	// stores, 0x8D takes the address)
+	void regData(uint8_t op, Reg reg, size_t dataOff){
+		rex(reg, Reg::RAX);
+		byte(op);
+		byte(static_cast<uint8_t>((num(reg) & 7) << 3 | 5));
+		//The code follows the data, and the displacement counts
+		// from the end of the instruction
+		imm32(static_cast<int64_t>(dataOff)
+			- static_cast<int64_t>(dataSize + size() + 4));
+	}
+	void movImm(Reg reg, int64_t val){
+		if (val >= INT32_MIN && val <= INT32_MAX){
+			rex(Reg::RAX, reg);
+			byte(0xC7);
+			byte(static_cast<uint8_t>(0xC0 | (num(reg) & 7)));
+			imm32(val);
+		} else {
+			rex(Reg::RAX, reg);
+			byte(static_cast<uint8_t>(0xB8 | (num(reg) & 7)));
+			imm64(val);
+		}
+	}
+	//A jump, conditional jump or call with a rel32 to patch;
+	// returns where the rel32 is
+	size_t rel32(std::initializer_list<uint8_t> opcode){
+		for (uint8_t b : opcode){ byte(b); }
+		size_t pos = size();
+		imm32(0);
+		return pos;
+	}
+	void patch(size_t pos, size_t target){
+		int64_t rel = static_cast<int64_t>(target) - static_cast<int64_t>(pos + 4);
+		uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(rel));
+		for (size_t i = 0; i < 4; i++){
+			bytes[pos + i] = static_cast<uint8_t>(bits >> (8 * i));
+		}
+	}
+	void rex(Reg reg, Reg rm){
+		byte(static_cast<uint8_t>(0x48 | (num(reg) >> 3) << 2 | (num(rm) >> 3)));
+	}
+private:
+
+	std::vector<uint8_t> bytes;
+	size_t dataSize;
+};
+
+//Where the data went: globals and string literals, as
+// offsets from the start of the buffer
+struct JitData{
+	HashMap<SemSymbol *, size_t> globals;
+	std::vector<size_t> strings;
+};
+
+//Writes one procedure's instructions as machine code
+class JitEmitter : public X64Emitter{
+public:
+	JitEmitter(JitProgram * jitIn, MachineCode& codeIn, const JitData& dataIn)
+	: jit(jitIn), code(codeIn), data(dataIn){ }
+	//Patch the jumps, once every label is placed
+	void finish();
+	//The calls made, as rel32 positions and callee names
+	std::vector<std::pair<size_t, std::string>> calls;
+
+	void label(LabelID label) override{ labels[label] = code.size(); }
+	void push(Reg reg) override{
+		if (num(reg) >= 8){ code.byte(0x41); }
+		code.byte(static_cast<uint8_t>(0x50 | (num(reg) & 7)));
+	}
+	void pop(Reg reg) override{
+		if (num(reg) >= 8){ code.byte(0x41); }
+		code.byte(static_cast<uint8_t>(0x58 | (num(reg) & 7)));
+	}
+	void ret() override{ code.byte(0xC3); }
+	void mov(Reg src, Reg dst) override{ code.regReg(0x89, src, dst); }
+	void movImm(int64_t val, Reg dst) override{ code.movImm(dst, val); }
+	void load(Reg base, int64_t disp, Reg dst) override{
+		if (base != Reg::RBP){
+			throw new InternalError("The JIT only loads from the frame");
+		}
+		code.regFrame(0x8B, dst, disp);
+	}
+	void store(Reg src, Reg base, int64_t disp) override{
+		if (base == Reg::RBP){
+			code.regFrame(0x89, src, disp);
+		} else if (base == Reg::RSP){
+			code.storeStack(src, disp);
+		} else {
+			throw new InternalError("The JIT only stores to the stack");
+		}
+	}
+	void loadGlobal(SemSymbol * global, Reg dst) override{
+		code.regData(0x8B, dst, data.globals.at(global));
+	}
+	void storeGlobal(Reg src, SemSymbol * global) override{
+		code.regData(0x89, src, data.globals.at(global));
+	}
+	void leaString(uint32_t str, Reg dst) override{
+		code.regData(0x8D, dst, data.strings[str]);
+	}
+	void alu(Alu op, Reg src, Reg dst) override;
+	void aluImm(Alu op, int32_t imm, Reg dst) override;
+	void neg(Reg reg) override{ unary(3, reg); }
+	void divide(Reg divisor) override{
+		//cqto
+		code.bytes2(0x48, 0x99);
+		unary(7, divisor);
+	}
+	void setcc(Cond cond) override{
+		//setcc %al; movzbq %al, %rax
+		code.bytes2(0x0F, static_cast<uint8_t>(0x90 | condCode(cond)));
+		code.byte(0xC0);
+		code.byte(0x48);
+		code.bytes2(0x0F, 0xB6);
+		code.byte(0xC0);
+	}
+	void jmp(LabelID target) override{
+		jumps.emplace_back(code.rel32({0xE9}), target);
+	}
+	void jcc(Cond cond, LabelID target) override{
+		jumps.emplace_back(code.rel32({0x0F,
+			static_cast<uint8_t>(0x80 | condCode(cond))}), target);
+	}
+	void call(SemSymbol * fn) override{
+		calls.emplace_back(code.rel32({0xE8}), fn->getName());
+	}
+	void callRuntime(RuntimeFn fn) override;
+private:
+	//The group 3 instructions (0xF7 /digit) on reg
+	void unary(uint8_t digit, Reg reg){
+		code.rex(Reg::RAX, reg);
+		code.byte(0xF7);
+		code.byte(static_cast<uint8_t>(0xC0 | digit << 3 | (num(reg) & 7)));
+	}
+	//The low nibble of jcc's and setcc's opcode
+	static uint8_t condCode(Cond cond);
+
+	JitProgram * jit;
+	MachineCode& code;
+	const JitData& data;
+	//Jumps to patch, and where each label landed
+	std::vector<std::pair<size_t, LabelID>> jumps;
+	HashMap<LabelID, size_t> labels;
+};
+
+uint8_t JitEmitter::condCode(Cond cond){
+	switch (cond){
+	case Cond::E: return 0x4;
+	case Cond::NE: return 0x5;
+	case Cond::L: return 0xC;
+	case Cond::G: return 0xF;
+	case Cond::LE: return 0xE;
+	case Cond::GE: return 0xD;
+	}
+	throw new InternalError("Bad condition");
+}
+
+void JitEmitter::alu(Alu op, Reg src, Reg dst){
+	switch (op){
+	case Alu::ADD: code.regReg(0x01, src, dst); return;
+	case Alu::SUB: code.regReg(0x29, src, dst); return;
+	case Alu::AND: code.regReg(0x21, src, dst); return;
+	case Alu::OR: code.regReg(0x09, src, dst); return;
+	case Alu::XOR: code.regReg(0x31, src, dst); return;
+	case Alu::CMP: code.regReg(0x39, src, dst); return;
+	case Alu::TEST: code.regReg(0x85, src, dst); return;
+	case Alu::IMUL:
+		//0x0F 0xAF takes its destination in the reg field
+		code.rex(dst, src);
+		code.bytes2(0x0F, 0xAF);
+		code.byte(static_cast<uint8_t>(0xC0 | (num(dst) & 7) << 3 | (num(src) & 7)));
+		return;
+	}
+	throw new InternalError("Bad ALU operation");
+}
+
+void JitEmitter::aluImm(Alu op, int32_t imm, Reg dst){
+	//0x81 /digit, with a 32-bit immediate
+	uint8_t digit = 0;
+	switch (op){
+	case Alu::ADD: digit = 0; break;
+	case Alu::OR: digit = 1; break;
+	case Alu::AND: digit = 4; break;
+	case Alu::SUB: digit = 5; break;
+	case Alu::XOR: digit = 6; break;
+	case Alu::CMP: digit = 7; break;
+	case Alu::IMUL:
+	case Alu::TEST:
+		throw new InternalError("No immediate form of this operation");
+	}
+	code.rex(Reg::RAX, dst);
+	code.byte(0x81);
+	code.byte(static_cast<uint8_t>(0xC0 | digit << 3 | (num(dst) & 7)));
+	code.imm32(imm);
+}
+
+void JitEmitter::callRuntime(RuntimeFn fn){
+	int64_t addr = 0;
+	switch (fn){
+	case RuntimeFn::PRINT_INT:
+		addr = reinterpret_cast<int64_t>(&JitProgram::printInt);
+		break;
+	case RuntimeFn::PRINT_BOOL:
+		addr = reinterpret_cast<int64_t>(&JitProgram::printBool);
+		break;
+	case RuntimeFn::PRINT_STRING:
+		addr = reinterpret_cast<int64_t>(&JitProgram::printString);
+		break;
+	case RuntimeFn::GET_INT:
+		addr = reinterpret_cast<int64_t>(&JitProgram::getInt);
+		break;
+	case RuntimeFn::GET_BOOL:
+		addr = reinterpret_cast<int64_t>(&JitProgram::getBool);
+		break;
+	}
+	//The program goes first, so the argument moves along one
+	code.regReg(0x89, Reg::RDI, Reg::RSI);
+	code.movImm(Reg::RDI, reinterpret_cast<int64_t>(jit));
+	code.movImm(Reg::RAX, addr);
+	//call *%rax
+	code.bytes2(0xFF, 0xD0);
+}
+
+void JitEmitter::finish(){
+	for (const auto& jump : jumps){
+		auto target = labels.find(jump.second);
+		if (target == labels.end()){
+			throw new InternalError("Jump to a label not in the procedure");
+		}
+		code.patch(jump.first, target->second);
+	}
+}
+
+static size_t roundToPages(size_t bytes){
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return (bytes + page - 1) / page * page;
+}
+
+JitProgram::JitProgram(IRProgram * prog)
+: mem(nullptr), memSize(0), dataSize(0), globalsSize(0), myCodeSize(0),
+  mainEntry(0), in(nullptr), out(nullptr){
+	JitData data;
+	std::vector<std::string> strings;
+	size_t used = 0;
+	for (SemSymbol * global : prog->getGlobals()){
+		data.globals[global] = used;
+		used += 8;
+	}
+	globalsSize = used;
+	for (size_t i = 0; i < prog->getStrings().size(); i++){
+		strings.push_back(prog->stringValue(static_cast<uint32_t>(i)));
+		data.strings.push_back(used);
+		used += strings.back().size() + 1;
+	}
+	dataSize = roundToPages(used);
+
+	MachineCode code(dataSize);
+	HashMap<std::string, size_t> entries;
+	std::vector<std::pair<size_t, std::string>> calls;
+	for (Procedure * proc : *prog->getProcs()){
+		entries[proc->getName()] = code.size();
+		JitEmitter emitter(this, code, data);
+		lowerX64(proc, emitter);
+		emitter.finish();
+		calls.insert(calls.end(), emitter.calls.begin(), emitter.calls.end());
+	}
+	for (const auto& call : calls){
+		auto callee = entries.find(call.second);
+		if (callee == entries.end()){
+			throw new InternalError("Call to a function with no body");
+		}
+		code.patch(call.first, callee->second);
+	}
+	auto main = entries.find("main");
+	if (main == entries.end()){
+		throw new InternalError("No main function to run");
+	}
+	mainEntry = main->second;
+	myCodeSize = code.size();
+
+	memSize = dataSize + roundToPages(myCodeSize);
+	void * region = mmap(nullptr, memSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (region == MAP_FAILED){
+		throw new InternalError("Couldn't map memory for the JIT");
+	}
+	mem = static_cast<uint8_t *>(region);
+	for (size_t i = 0; i < strings.size(); i++){
+		memcpy(mem + data.strings[i], strings[i].c_str(), strings[i].size() + 1);
+	}
+	memcpy(mem + dataSize, code.data(), myCodeSize);
+	if (mprotect(mem + dataSize, memSize - dataSize, PROT_READ | PROT_EXEC) != 0){
+		throw new InternalError("Couldn't make the JIT's code executable");
+	}
+}
+
+JitProgram::~JitProgram(){
+	if (mem != nullptr){ munmap(mem, memSize); }
+}
+
+int64_t JitProgram::run(std::istream& inIn, std::ostream& outIn){
+	in = &inIn;
+	out = &outIn;
+	memset(mem, 0, globalsSize);
+	int64_t (*main)() = reinterpret_cast<int64_t (*)()>(mem + dataSize + mainEntry);
+	int64_t res = main();
+	out->flush();
+	return res;
+}
+
+void JitProgram::printInt(JitProgram * jit, int64_t val){
+	*jit->out << val;
+}
+
+void JitProgram::printBool(JitProgram * jit, int64_t val){
+	*jit->out << (val ? "true" : "false");
+}
+
+void JitProgram::printString(JitProgram * jit, const char * val){
+	*jit->out << val;
+}
+
+int64_t JitProgram::getInt(JitProgram * jit){
+	return receiveInt(*jit->in, *jit->out);
+}
+
+int64_t JitProgram::getBool(JitProgram * jit){
+	return receiveBool(*jit->in, *jit->out);
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef CSHANTY_JIT_HPP
+#define CSHANTY_JIT_HPP
+
+#include <istream>
+#include <ostream>
+#include <stdint.h>
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//A template JIT for x86-64 Linux: every procedure goes
+// through the same lowering as -o (lowerX64, see x64.hpp),
+// with an emitter that encodes each instruction straight into
+// one mmap'd buffer, and main is then called directly. The
+// code is what -o would have the assembler make, so no
+// assembler or linker is needed and compiling takes one pass
+// over the quads.
+//
+//The buffer holds the globals and string literals, in
+// pages left writable, followed by the code, made executable
+// (and no longer writable) once it is written. Jumps, calls
+// and references to the data are rel32 displacements, patched
+// once their targets are placed. REPORT and RECEIVE call back
+// into this class, which does the input and output.
+class JitProgram{
+public:
+	//Compile prog, which must be out of SSA form. It may have
+	// been optimized, and registers allocated (at most 7).
+	explicit JitProgram(IRProgram * prog);
+	~JitProgram();
+	JitProgram(const JitProgram&) = delete;
+	JitProgram& operator=(const JitProgram&) = delete;
+
+	//Run main, reading input from in and writing output to
+	// out, and return its result
+	int64_t run(std::istream& in, std::ostream& out);
+	size_t codeSize() const { return myCodeSize; }
+private:
+	//The runtime the generated code calls, with this program
+	// as the first argument
+	static void printInt(JitProgram * jit, int64_t val);
+	static void printBool(JitProgram * jit, int64_t val);
+	static void printString(JitProgram * jit, const char * val);
+	static int64_t getInt(JitProgram * jit);
+	static int64_t getBool(JitProgram * jit);
+	friend class JitEmitter;
+
+	uint8_t * mem;
+	size_t memSize;
+	//The data pages come first; the globals are at their start
+	size_t dataSize;
+	size_t globalsSize;
+	size_t myCodeSize;
+	size_t mainEntry;
+	std::istream * in;
+	std::ostream * out;
+};
+
+}
+
+#endif
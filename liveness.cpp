@@ -0,0 +1,106 @@
+#include <deque>
+#include "liveness.hpp"
+
+namespace cshanty{
+
+const uint32_t Liveness::NO_SLOT;
+
+Liveness::Liveness(const CFG& cfg) : myVisits(0){
+	findSlots(cfg);
+	solve(cfg);
+}
+
+void Liveness::findSlots(const CFG& cfg){
+	const Procedure * proc = cfg.getProc();
+	variable.assign(proc->numOpds(), false);
+	for (OpdID opd : proc->getFormals()){ variable[opd] = true; }
+	for (OpdID opd : proc->getLocals()){ variable[opd] = true; }
+	for (OpdID opd : proc->getTemps()){ variable[opd] = true; }
+
+	//A variable needs a slot if some block reads it before
+	// writing it. defBlock holds (block + 1) of each
+	// variable's latest write, so it needn't be reset
+	// between blocks.
+	slots.assign(proc->numOpds(), NO_SLOT);
+	std::vector<BlockID> defBlock(proc->numOpds(), 0);
+	const std::vector<Quad>& body = cfg.getProc()->getBody();
+	for (BlockID b = 0; b < cfg.numBlocks(); b++){
+		for (size_t i = cfg.first(b); i < cfg.end(b); i++){
+			const Quad& quad = body[i];
+			for (OpdID src : {quad.getSrc1(), quad.getSrc2()}){
+				if (isVariable(src) && defBlock[src] != b + 1
+				  && slots[src] == NO_SLOT){
+					slots[src] = static_cast<uint32_t>(slotOpds.size());
+					slotOpds.push_back(src);
+				}
+			}
+			OpdID dst = quad.getDst();
+			if (isVariable(dst)){ defBlock[dst] = b + 1; }
+		}
+	}
+}
+
+void Liveness::solve(const CFG& cfg){
+	size_t blocks = cfg.numBlocks();
+	size_t width = numSlots();
+	const std::vector<Quad>& body = cfg.getProc()->getBody();
+
+	//gen: slots read in the block before any write to them
+	//kill: slots written in the block
+	std::vector<BitSet> gens(blocks, BitSet(width));
+	std::vector<BitSet> kills(blocks, BitSet(width));
+	for (BlockID b = 0; b < blocks; b++){
+		for (size_t i = cfg.first(b); i < cfg.end(b); i++){
+			const Quad& quad = body[i];
+			for (OpdID src : {quad.getSrc1(), quad.getSrc2()}){
+				uint32_t slot = slotOf(src);
+				if (slot != NO_SLOT && !kills[b].test(slot)){
+					gens[b].set(slot);
+				}
+			}
+			uint32_t slot = slotOf(quad.getDst());
+			if (slot != NO_SLOT){ kills[b].set(slot); }
+		}
+	}
+
+	ins.assign(blocks, BitSet(width));
+	outs.assign(blocks, BitSet(width));
+
+	//Liveness flows backward, so start from the end of the
+	// reverse postorder: most blocks then see their
+	// successors' final sets on the first visit
+	const std::vector<BlockID>& rpo = cfg.rpo();
+	std::deque<BlockID> worklist(rpo.rbegin(), rpo.rend());
+	std::vector<bool> queued(blocks, false);
+	for (BlockID b : rpo){ queued[b] = true; }
+
+	while (!worklist.empty()){
+		BlockID block = worklist.front();
+		worklist.pop_front();
+		queued[block] = false;
+		myVisits++;
+
+		BitSet& out = outs[block];
+		for (BlockID succ : cfg.succs(block)){
+			out.unionWith(ins[succ]);
+		}
+		if (!ins[block].assignTransfer(gens[block], out, kills[block])){
+			continue;
+		}
+		for (BlockID pred : cfg.preds(block)){
+			if (!queued[pred] && cfg.reachable(pred)){
+				queued[pred] = true;
+				worklist.push_back(pred);
+			}
+		}
+	}
+}
+
+bool Liveness::isLiveOut(BlockID block, OpdID opd) const{
+	if (!isVariable(opd)){ return true; }
+	uint32_t slot = slotOf(opd);
+	if (slot == NO_SLOT){ return false; }
+	return outs[block].test(slot);
+}
+
+}
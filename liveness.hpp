@@ -0,0 +1,64 @@
+#ifndef CSHANTY_LIVENESS_HPP
+#define CSHANTY_LIVENESS_HPP
+
+#include <vector>
+#include "bitset.hpp"
+#include "cfg.hpp"
+
+namespace cshanty{
+
+//Live variable analysis over a procedure's CFG. Variables
+// are the procedure's temps, locals and formals; globals,
+// functions, strings and address temps stand for memory
+// that outlives the procedure (or is reached through a
+// pointer), so they are never tracked and always count as
+// live.
+//
+//Only variables that are read in some block before being
+// written in it can be live on entry to (or exit from) any
+// block, and flattening makes most temps local to a single
+// block. Those block-crossing variables are numbered
+// densely as slots, and the per-block sets are bitsets over
+// slots, so their size doesn't grow with the number of
+// short-lived temps. A pass needing liveness at each quad
+// walks a block backward from liveOut (see isVariable).
+class Liveness{
+public:
+	static const uint32_t NO_SLOT = UINT32_MAX;
+
+	explicit Liveness(const CFG& cfg);
+
+	//Whether opd is a temp, local or formal of the procedure.
+	// Operands made after the analysis ran are not.
+	bool isVariable(OpdID opd) const {
+		return opd < variable.size() && variable[opd];
+	}
+	//The dense slot of a block-crossing variable, or NO_SLOT
+	uint32_t slotOf(OpdID opd) const {
+		return opd < slots.size() ? slots[opd] : NO_SLOT;
+	}
+	OpdID opdOfSlot(uint32_t slot) const { return slotOpds[slot]; }
+	size_t numSlots() const { return slotOpds.size(); }
+
+	//Sets of slots live on entry to and exit from block
+	const BitSet& liveIn(BlockID block) const { return ins[block]; }
+	const BitSet& liveOut(BlockID block) const { return outs[block]; }
+	bool isLiveOut(BlockID block, OpdID opd) const;
+
+	//The number of block visits the solver made
+	size_t visits() const { return myVisits; }
+private:
+	void findSlots(const CFG& cfg);
+	void solve(const CFG& cfg);
+
+	std::vector<bool> variable;
+	std::vector<uint32_t> slots;
+	std::vector<OpdID> slotOpds;
+	std::vector<BitSet> ins;
+	std::vector<BitSet> outs;
+	size_t myVisits;
+};
+
+}
+
+#endif
@@ -1,12 +1,25 @@
+#include <atomic>
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <mutex>
+#include <sstream>
 #include <string.h>
+#include <thread>
+#include <vector>
 #include "errors.hpp"
 #include "scanner.hpp"
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "cfg.hpp"
+#include "opt.hpp"
+#include "ssa.hpp"
+#include "regalloc.hpp"
+#include "interp.hpp"
+#include "jit.hpp"
+#include "x64.hpp"
+#include "stats.hpp"
 
 using namespace cshanty;
 
@@ -18,23 +31,50 @@ static void usageAndDie(){
 	<< " [-n <nameFile>]: Perform name analysis\n"
 	<< " [-c]: Do type checking\n"
 	<< " [-a <3ACFile>]: Output program as 3-address code\n"
+	<< " [-O]: Optimize the 3AC before writing it out\n"
+	<< " [--opt-report]: Like -O, and summarize what the"
+	<< " optimizer did on stderr\n"
+	<< " [--regs <K>]: Allocate K registers to each function's"
+	<< " variables (at most 7 with -o or --jit)\n"
+	<< " [-cfg <dotFile>]: Output each function's control-flow"
+	<< " graph in DOT format\n"
+	<< " [-ssa <3ACFile>]: Output the 3AC in SSA form\n"
+	<< " [-o <asmFile>]: Output x86-64 assembly, to be linked"
+	<< " with stdcshanty.o\n"
+	<< " [--run]: Interpret the program, exiting with main's"
+	<< " result\n"
+	<< " [--jit]: Like --run, but compile to machine code in"
+	<< " memory and run that\n"
+	<< " [--stats <jsonFile>]: Write the time and allocations"
+	<< " of each phase as JSON\n"
+	<< "   or: cshantyc --batch [-j <n>] [-p] [-c] [-a] [-O]"
+	<< " [--opt-report] [--regs <K>]"
+	<< " <infile|@manifest>...\n"
+	<< " Compile many inputs on <n> threads; -a writes each"
+	<< " foo.cshanty's 3AC to foo.3ac\n"
 	;
 	exit(1);
 }
 
-static void writeTokenStream(const char * inPath, const char * outPath){
-	std::ifstream inStream(inPath);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream";
+static void openSource(cshanty::SourceFile& source, const char * inPath){
+	if (!source.open(inPath)){
+		std::string msg = "Bad input stream ";
 		msg += inPath;
 		throw new cshanty::InternalError(msg.c_str());
 	}
+}
+
+static void writeTokenStream(const cshanty::SourceFile& source, 
+	const char * outPath){
 	if (outPath == nullptr){
 		std::string msg = "No tokens output file given";
 		throw new cshanty::InternalError(msg.c_str());
 	}
 
-	Scanner scanner(&inStream);
+	cshanty::Arena arena;
+	cshanty::SourceMap srcMap;
+	cshanty::Interner names;
+	Scanner scanner(&source, &arena, &srcMap, &names);
 	if (strcmp(outPath, "--") == 0){
 		scanner.outputTokens(std::cout);
 	} else {
@@ -49,20 +89,20 @@ static void writeTokenStream(const char * inPath, const char * outPath){
 	}
 }
 
-static cshanty::ProgramNode * parse(const char * inFile){
-	std::ifstream inStream(inFile);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream ";
-		msg += inFile;
-		throw new InternalError(msg.c_str());
-	}
-
+//The AST (and every token it was built from) is allocated
+// in the given arena, and is only valid while it lives.
+// Line starts are recorded in srcMap for diagnostics, and
+// identifiers are interned in names.
+static cshanty::ProgramNode * parse(const cshanty::SourceFile& source, 
+	cshanty::Arena& arena, cshanty::SourceMap& srcMap,
+	cshanty::Interner& names){
 	//This pointer will be set to the root of the
 	// AST after parsing
 	cshanty::ProgramNode * root = nullptr;
 
-	cshanty::Scanner scanner(&inStream);
-	cshanty::Parser parser(scanner, &root);
+	cshanty::Scanner scanner(&source, &arena, &srcMap, &names);
+	cshanty::ASTNode::resetIDs();
+	cshanty::Parser parser(scanner, &root, arena);
 
 	int errCode = parser.parse();
 	if (errCode != 0){ return nullptr; }
@@ -84,17 +124,15 @@ static void outputAST(ASTNode * ast, const char * outPath){
 	}
 }
 
-static cshanty::NameAnalysis * doNameAnalysis(const char * inputPath){
-	cshanty::ProgramNode * ast = parse(inputPath);
+static cshanty::NameAnalysis * doNameAnalysis(cshanty::ProgramNode * ast){
 	if (ast == nullptr){ return nullptr; }
 	
 	return cshanty::NameAnalysis::build(ast);
 }
 
-static bool doUnparsing(const char * inputPath, const char * outPath){
-	cshanty::ProgramNode * ast = parse(inputPath);
+static bool doUnparsing(cshanty::ProgramNode * ast, const char * outPath){
 	if (ast == nullptr){ 
-		std::cerr << "No AST built\n";
+		Report::err() << "No AST built\n";
 		return false;
 	}
 
@@ -102,8 +140,7 @@ static bool doUnparsing(const char * inputPath, const char * outPath){
 	return true;
 }
 
-static cshanty::TypeAnalysis * doTypeAnalysis(const char * inputPath){
-	cshanty::NameAnalysis * nameAnalysis = doNameAnalysis(inputPath);
+static cshanty::TypeAnalysis * doTypeAnalysis(cshanty::NameAnalysis * nameAnalysis){
 	if (nameAnalysis == nullptr){ return nullptr; }
 	return TypeAnalysis::build(nameAnalysis);
 }
@@ -112,29 +149,461 @@ static void write3AC(cshanty::IRProgram * prog, const char * outPath){
 	if (outPath == nullptr){
 		throw new InternalError("Null 3AC flat file given");
 	}
-	std::string flatProg = prog->toString();
 	if (strcmp(outPath, "--") == 0){
-		std::cout << flatProg << std::endl;
+		prog->emit(std::cout);
+		std::cout << std::endl;
 	} else {
-		std::ofstream outStream(outPath);
-		outStream << flatProg << std::endl;
+		//Quads are streamed out one at a time, so give the
+		// file a large buffer to write them into
+		std::vector<char> buffer(1 << 20);
+		std::ofstream outStream;
+		outStream.rdbuf()->pubsetbuf(buffer.data(), 
+			static_cast<std::streamsize>(buffer.size()));
+		outStream.open(outPath);
+		prog->emit(outStream);
+		outStream << std::endl;
 		outStream.close();
 	}
 }
 
+static void writeCFG(cshanty::IRProgram * prog, const char * outPath){
+	if (strcmp(outPath, "--") == 0){
+		writeDotFile(prog, std::cout);
+	} else {
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new InternalError(msg.c_str());
+		}
+		writeDotFile(prog, outStream);
+	}
+}
+
+static void reportOpt(const OptStats& stats){
+	Report::err() << "optimized " << stats.quadsBefore << " -> "
+		<< stats.quadsAfter << " quads, "
+		<< stats.tempsBefore << " -> " << stats.tempsAfter << " temps ("
+		<< stats.constantsFolded << " folded, "
+		<< stats.valuesReused << " recomputations reused, "
+		<< stats.copiesPropagated << " copies propagated, "
+		<< stats.deadQuads << " dead; "
+		<< stats.deadTemps << " temps dropped, "
+		<< stats.tempsCoalesced << " coalesced)\n";
+}
+
+static void reportRegAlloc(const RegAllocStats& stats){
+	Report::err() << "allocated " << stats.inRegisters << " of "
+		<< stats.variables << " variables to registers ("
+		<< stats.spilled << " spilled, "
+		<< stats.spillQuads << " spill quads, "
+		<< stats.reloadQuads << " reload quads, "
+		<< stats.slotsBefore - stats.slotsAfter << " slots saved, "
+		<< stats.colored << " colored)\n";
+}
+
+static void writeX64(cshanty::IRProgram * prog, const char * outPath){
+	if (strcmp(outPath, "--") == 0){
+		prog->toX64(std::cout);
+		return;
+	}
+	//Like the 3AC, the assembly is streamed out as it's made
+	std::vector<char> buffer(1 << 20);
+	std::ofstream outStream;
+	outStream.rdbuf()->pubsetbuf(buffer.data(), 
+		static_cast<std::streamsize>(buffer.size()));
+	outStream.open(outPath);
+	if (!outStream.good()){
+		std::string msg = "Bad output file ";
+		msg += outPath;
+		throw new InternalError(msg.c_str());
+	}
+	prog->toX64(outStream);
+	outStream.close();
+}
+
+//Write prog's 3AC in SSA form. The program is taken back
+// out of SSA form afterward, so any later phase or output
+// sees it as the same program (though not quad for quad).
+static void writeSSA(cshanty::IRProgram * prog, const char * outPath){
+	for (Procedure * proc : *prog->getProcs()){
+		toSSA(proc);
+	}
+	if (strcmp(outPath, "--") == 0){
+		prog->emit(std::cout);
+		std::cout << std::endl;
+	} else {
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new InternalError(msg.c_str());
+		}
+		prog->emit(outStream);
+		outStream << std::endl;
+	}
+	for (Procedure * proc : *prog->getProcs()){
+		fromSSA(proc);
+	}
+}
 
-static IRProgram * do3AC(const char * inputPath){
-	cshanty::TypeAnalysis * typeAnalysis = doTypeAnalysis(inputPath);
+static IRProgram * do3AC(cshanty::TypeAnalysis * typeAnalysis){
 	if (typeAnalysis == nullptr){ return nullptr; }
 	
 	IRProgram * prog = typeAnalysis->ast->to3AC(typeAnalysis);
+	if (!prog->passed()){
+		Report::err() << "3AC Generation Failed\n";
+		return nullptr;
+	}
 	return prog;
 }
 
+//What to produce from a single input file. A null path
+// means that output isn't wanted.
+struct Outputs{
+	const char * tokensFile = nullptr;
+	bool checkParse = false;
+	const char * unparseFile = nullptr;
+	const char * namesFile = nullptr;
+	bool checkTypes = false;
+	const char * threeACFile = nullptr;
+	const char * cfgFile = nullptr;
+	const char * ssaFile = nullptr;
+	const char * x64File = nullptr;
+	bool optimize = false;
+	bool optReport = false;
+	//Registers to allocate, or 0 to leave variables in memory
+	size_t numRegs = 0;
+	bool run = false;
+	bool jit = false;
+	const char * statsFile = nullptr;
+};
+
+//Time scanning on its own. The parser pulls tokens as it
+// goes, so this is a pass of its own, with its diagnostics
+// (which the parse will repeat) thrown away.
+static void timeScan(const cshanty::SourceFile& source, PhaseStats& stats){
+	std::ostringstream discard;
+	std::ostream * prevSink = Report::redirection();
+	Report::redirect(&discard);
+	stats.begin("scan");
+	cshanty::Arena arena;
+	cshanty::SourceMap srcMap;
+	cshanty::Interner names;
+	Scanner scanner(&source, &arena, &srcMap, &names);
+	stats.count("tokens", scanner.scanAll());
+	stats.end();
+	Report::redirect(prevSink);
+}
+
+static void writeStats(const PhaseStats& stats, const char * inFile,
+	const char * outPath){
+	if (strcmp(outPath, "--") == 0){
+		stats.writeJSON(std::cout, inFile);
+		return;
+	}
+	std::ofstream outStream(outPath);
+	if (!outStream.good()){
+		std::string msg = "Bad output file ";
+		msg += outPath;
+		throw new InternalError(msg.c_str());
+	}
+	stats.writeJSON(outStream, inFile);
+}
+
+//Run one compilation from start to finish. Everything the
+// compilation builds is owned by (or reachable only from)
+// this call, so separate calls may run on separate threads.
+// Returns the process exit code for this input.
+static int compile(const char * inFile, const Outputs& outs){
+	//Each phase runs at most once; every requested output
+	// shares the results of the phases before it
+	bool need3AC = outs.threeACFile != nullptr 
+		|| outs.cfgFile != nullptr || outs.ssaFile != nullptr
+		|| outs.x64File != nullptr || outs.run || outs.jit;
+	int exitCode = 0;
+	PhaseStats stats(outs.statsFile != nullptr);
+	bool needTypes = outs.checkTypes || need3AC;
+	bool needNames = needTypes || outs.namesFile != nullptr;
+	bool needAST = needNames || outs.checkParse 
+		|| outs.unparseFile != nullptr;
+
+	try {
+		//The input is loaded once and stays in memory (mapped,
+		// where possible) until the compilation is done
+		cshanty::SourceFile source;
+		openSource(source, inFile);
+
+		if (outs.tokensFile != nullptr){
+			writeTokenStream(source, outs.tokensFile);
+		}
+		if (stats.isEnabled() && needAST){
+			timeScan(source, stats);
+		}
+
+		//Owns the AST for the rest of the compilation,
+		// releasing it all at once on the way out
+		cshanty::Arena arena;
+		cshanty::SourceMap srcMap;
+		cshanty::Interner names;
+		cshanty::ProgramNode * ast = nullptr;
+		if (needAST){
+			stats.begin("parse");
+			ast = parse(source, arena, srcMap, names);
+			stats.end();
+			stats.count("ast_nodes", ASTNode::idsIssued());
+			stats.count("arena_objects", arena.objectCount());
+			stats.count("arena_bytes", arena.bytesUsed());
+		}
+		if (outs.checkParse){
+			if (!ast){
+				Report::err() << "Parse failed" << std::endl;
+			}
+		}
+		if (outs.unparseFile != nullptr){
+			doUnparsing(ast, outs.unparseFile);
+		}
+
+		cshanty::NameAnalysis * na = nullptr;
+		if (needNames){
+			stats.begin("name_analysis");
+			na = doNameAnalysis(ast);
+			stats.end();
+			if (na != nullptr){ stats.count("symbols", na->numSymbols); }
+		}
+		if (outs.namesFile){
+			if (na == nullptr){
+				Report::err() << "Name Analysis Failed\n";
+				return 1;
+			}
+			outputAST(na->ast, outs.namesFile);
+		}
+
+		cshanty::TypeAnalysis * ta = nullptr;
+		if (needTypes){
+			stats.begin("type_analysis");
+			ta = doTypeAnalysis(na);
+			stats.end();
+		}
+		if (outs.checkTypes){
+			if (ta == nullptr){
+				Report::err() << "Type Analysis Failed\n";
+				return 1;
+			}
+		}
+		if (need3AC){
+			stats.begin("to3AC");
+			auto prog = do3AC(ta);
+			stats.end();
+			if (prog == nullptr){ return 1; }
+			if (stats.isEnabled()){
+				size_t quads = 0;
+				size_t temps = 0;
+				for (Procedure * proc : *prog->getProcs()){
+					quads += proc->getBody().size();
+					temps += proc->getTemps().size();
+				}
+				stats.count("quads", quads);
+				stats.count("temps", temps);
+				stats.count("labels", prog->numLabels());
+			}
+			if (outs.optimize){
+				stats.begin("optimize");
+				OptStats optStats = cshanty::optimize(prog);
+				stats.end();
+				if (outs.optReport){ reportOpt(optStats); }
+			}
+			//Before register allocation, which must come last
+			if (outs.ssaFile != nullptr){
+				stats.begin("writeSSA");
+				writeSSA(prog, outs.ssaFile);
+				stats.end();
+			}
+			if (outs.numRegs > 0){
+				stats.begin("regalloc");
+				RegAllocStats regStats = allocateRegisters(prog, outs.numRegs);
+				stats.end();
+				if (outs.optReport){ reportRegAlloc(regStats); }
+			}
+			if (outs.threeACFile != nullptr){
+				stats.begin("write3AC");
+				write3AC(prog, outs.threeACFile);
+				stats.end();
+			}
+			if (outs.cfgFile != nullptr){
+				stats.begin("writeCFG");
+				writeCFG(prog, outs.cfgFile);
+				stats.end();
+			}
+			if (outs.x64File != nullptr){
+				stats.begin("writeX64");
+				writeX64(prog, outs.x64File);
+				stats.end();
+			}
+			if (outs.run){
+				stats.begin("run");
+				Interpreter interp(prog);
+				exitCode = static_cast<int>(interp.run(std::cin, std::cout));
+				std::cout.flush();
+				stats.end();
+			} else if (outs.jit){
+				stats.begin("jit");
+				JitProgram jit(prog);
+				exitCode = static_cast<int>(jit.run(std::cin, std::cout));
+				stats.end();
+			}
+		}
+		if (outs.statsFile != nullptr){
+			writeStats(stats, inFile, outs.statsFile);
+		}
+	} catch (cshanty::ToDoError * e){
+		Report::err() << "ToDoError: " << e->msg() << "\n";
+		return 1;
+	} catch (cshanty::InternalError * e){
+		Report::err() << "InternalError: " << e->msg() << "\n";
+		return 1;
+	}
+
+	return exitCode;
+}
+
+//The register count after --regs
+static size_t readNumRegs(const int argc, const char **argv, int& i){
+	i++;
+	if (i >= argc){ usageAndDie(); }
+	int count = atoi(argv[i]);
+	if (count <= 0){ usageAndDie(); }
+	return static_cast<size_t>(count);
+}
+
+//Add the inputs listed in a manifest (one path per line,
+// blank lines and lines starting with # ignored)
+static void readManifest(const char * path, std::vector<std::string>& inputs){
+	std::ifstream manifest(path);
+	if (!manifest.good()){
+		std::cerr << "Bad manifest " << path << std::endl;
+		usageAndDie();
+	}
+	std::string line;
+	while (std::getline(manifest, line)){
+		if (line.empty() || line[0] == '#'){ continue; }
+		inputs.push_back(line);
+	}
+}
+
+//The 3AC for foo.cshanty is written to foo.3ac
+static std::string threeACPathFor(const std::string& inPath){
+	const std::string ext = ".cshanty";
+	if (inPath.length() > ext.length() 
+	  && inPath.compare(inPath.length() - ext.length(), ext.length(), ext) == 0){
+		return inPath.substr(0, inPath.length() - ext.length()) + ".3ac";
+	}
+	return inPath + ".3ac";
+}
+
+//Batch mode: compile every input (given directly, or listed
+// in an @manifest) on a pool of worker threads. Each
+// compilation's diagnostics are collected and printed 
+// together once it finishes, headed by its input's name.
+static int runBatch(const int argc, const char **argv){
+	Outputs outs;
+	bool write3ACFiles = false;
+	size_t workers = std::thread::hardware_concurrency();
+	std::vector<std::string> inputs;
+	for (int i = 2 ; i < argc ; i++){
+		if (argv[i][0] == '@'){
+			readManifest(argv[i] + 1, inputs);
+		} else if (strcmp(argv[i], "-j") == 0){
+			i++;
+			if (i >= argc){ usageAndDie(); }
+			int count = atoi(argv[i]);
+			if (count <= 0){ usageAndDie(); }
+			workers = static_cast<size_t>(count);
+		} else if (strcmp(argv[i], "-p") == 0){
+			outs.checkParse = true;
+		} else if (strcmp(argv[i], "-c") == 0){
+			outs.checkTypes = true;
+		} else if (strcmp(argv[i], "-a") == 0){
+			write3ACFiles = true;
+		} else if (strcmp(argv[i], "-O") == 0){
+			outs.optimize = true;
+		} else if (strcmp(argv[i], "--opt-report") == 0){
+			outs.optimize = true;
+			outs.optReport = true;
+		} else if (strcmp(argv[i], "--regs") == 0){
+			outs.numRegs = readNumRegs(argc, argv, i);
+		} else if (argv[i][0] == '-'){
+			std::cerr << "Unrecognized batch argument: ";
+			std::cerr << argv[i] << std::endl;
+			usageAndDie();
+		} else {
+			inputs.push_back(argv[i]);
+		}
+	}
+	if (inputs.empty()){ usageAndDie(); }
+	if (!outs.checkParse && !outs.checkTypes && !write3ACFiles){
+		std::cerr << "Hey, you didn't tell cshantyc to do anything!\n";
+		usageAndDie();
+	}
+	if (workers == 0){ workers = 1; }
+	if (workers > inputs.size()){ workers = inputs.size(); }
+
+	std::vector<std::string> outPaths(inputs.size());
+	for (size_t i = 0; i < inputs.size(); i++){
+		outPaths[i] = threeACPathFor(inputs[i]);
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<int> failures(0);
+	std::mutex printLock;
+	auto work = [&](){
+		while (true){
+			size_t idx = next++;
+			if (idx >= inputs.size()){ return; }
+
+			Outputs mine = outs;
+			if (write3ACFiles){ 
+				mine.threeACFile = outPaths[idx].c_str(); 
+			}
+			std::ostringstream messages;
+			Report::redirect(&messages);
+			int code = compile(inputs[idx].c_str(), mine);
+			Report::redirect(nullptr);
+
+			if (code != 0){ failures++; }
+			std::string text = messages.str();
+			if (!text.empty()){
+				std::lock_guard<std::mutex> guard(printLock);
+				std::cerr << inputs[idx] << ":\n" << text;
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < workers; i++){
+		pool.emplace_back(work);
+	}
+	work();
+	for (std::thread& worker : pool){
+		worker.join();
+	}
+
+	if (failures > 0){
+		std::cerr << failures << " of " << inputs.size() 
+			<< " inputs failed\n";
+		return 1;
+	}
+	return 0;
+}
+
 int 
 main( const int argc, const char **argv )
 {
 	if (argc <= 1){ usageAndDie(); }
+	if (strcmp(argv[1], "--batch") == 0){
+		return runBatch(argc, argv);
+	}
+
 	std::ifstream * input = new std::ifstream(argv[1]);
 	if (input == nullptr){ usageAndDie(); }
 	if (!input->good()){
@@ -143,40 +612,67 @@ main( const int argc, const char **argv )
 	}
 
 	const char * inFile = NULL;
-	const char * tokensFile = NULL;
-	bool checkParse = false;
-	const char * unparseFile = NULL;
-	const char * namesFile = NULL;
-	bool checkTypes = false;
-	const char * threeACFile = NULL;
+	Outputs outs;
 
 	bool useful = false;
 	int i = 1;
 	for (int i = 1 ; i < argc ; i++){
 		if (argv[i][0] == '-'){
-			if (argv[i][1] == 't'){
+			if (strcmp(argv[i], "--opt-report") == 0){
+				outs.optimize = true;
+				outs.optReport = true;
+			} else if (strcmp(argv[i], "--regs") == 0){
+				outs.numRegs = readNumRegs(argc, argv, i);
+			} else if (strcmp(argv[i], "--run") == 0){
+				outs.run = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--jit") == 0){
+				outs.jit = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--stats") == 0){
 				i++;
-				tokensFile = argv[i];
+				if (i >= argc){ usageAndDie(); }
+				outs.statsFile = argv[i];
+			} else if (strcmp(argv[i], "-cfg") == 0){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				outs.cfgFile = argv[i];
+				useful = true;
+			} else if (strcmp(argv[i], "-ssa") == 0){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				outs.ssaFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 't'){
+				i++;
+				outs.tokensFile = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'p'){
-				checkParse = true;
+				outs.checkParse = true;
 				useful = true;
 			} else if (argv[i][1] == 'u'){
 				i++;
 				if (i >= argc){ usageAndDie(); }
-				unparseFile = argv[i];
+				outs.unparseFile = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'n'){
 				i++;
-				namesFile = argv[i];
+				outs.namesFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'O'){
+				outs.optimize = true;
+			} else if (argv[i][1] == 'o'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				outs.x64File = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'c'){
-				checkTypes = true;
+				outs.checkTypes = true;
 				useful = true;
 			} else if (argv[i][1] == 'a'){
 				i++;
 				if (i >= argc){ usageAndDie(); }
-				threeACFile = argv[i];
+				outs.threeACFile = argv[i];
 				useful = true;
 			} else {
 				std::cerr << "Unrecognized argument: ";
@@ -200,48 +696,11 @@ main( const int argc, const char **argv )
 		std::cerr << "Hey, you didn't tell cshantyc to do anything!\n";
 		usageAndDie();
 	}
-
-	try {
-		if (tokensFile != nullptr){
-			writeTokenStream(inFile, tokensFile);
-		}
-		if (checkParse){
-			if (!parse(inFile)){
-				std::cerr << "Parse failed" << std::endl;
-			}
-		}
-		if (unparseFile != nullptr){
-			doUnparsing(inFile, unparseFile);
-		}
-		if (namesFile){
-			cshanty::NameAnalysis * na;
-			na = doNameAnalysis(inFile);
-			if (na == nullptr){
-				std::cerr << "Name Analysis Failed\n";
-				return 1;
-			}
-			outputAST(na->ast, namesFile);
-		}
-		if (checkTypes){
-			cshanty::TypeAnalysis * ta;
-			ta = doTypeAnalysis(inFile);
-			if (ta == nullptr){
-				std::cerr << "Type Analysis Failed\n";
-				return 1;
-			}
-		}
-		if (threeACFile != nullptr){
-			auto prog = do3AC(inFile);
-			if (prog == nullptr){ return 1; }
-			write3AC(prog, threeACFile);
-		}
-	} catch (cshanty::ToDoError * e){
-		std::cerr << "ToDoError: " << e->msg() << "\n";
-		return 1;
-	} catch (cshanty::InternalError * e){
-		std::cerr << "InternalError: " << e->msg() << "\n";
-		return 1;
+	if (outs.numRegs > NUM_ALLOC_REGS && (outs.x64File != nullptr || outs.jit)){
+		std::cerr << "--regs can be at most " << NUM_ALLOC_REGS
+			<< " with -o or --jit\n";
+		usageAndDie();
 	}
 
-	return 0;
+	return compile(inFile, outs);
 }
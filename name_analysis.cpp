@@ -80,7 +80,7 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	bool checkType = myType->nameAnalysis(symTab);
 
 	const DataType * dataType = getTypeNode()->getType();
-	std::string varName = ID()->getName();
+	Ident varName = ID()->getName();
 
 	bool validType = true;
 	if (dataType == nullptr){
@@ -107,17 +107,18 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool RecordTypeDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string name = myID->getName();
+	Ident name = myID->getName();
 	if (symTab->find(name) != nullptr){
 		NameErr::multiDecl(this->pos());
 		return false;
 	}
 
-	auto fields = new HashMap<std::string, const DataType *>();
+	auto fields = new HashMap<Ident, const DataType *>();
+	std::vector<Ident> fieldNames;
 	SymbolTable t;
 	t.enterScope();
 	for(auto elt : *myFields){
-		std::string fieldName = elt->ID()->getName();
+		Ident fieldName = elt->ID()->getName();
 		SemSymbol * sym = t.find(fieldName);
 		if (sym != nullptr){
 			NameErr::multiDecl(elt->pos());
@@ -131,53 +132,51 @@ bool RecordTypeDeclNode::nameAnalysis(SymbolTable * symTab){
 			return false;
 		}
 		(*fields)[fieldName] = sym->getDataType();
+		fieldNames.push_back(fieldName);
 		t.addVar(fieldName, sym->getDataType());
 	}
 	t.leaveScope();
-	RecordType * r = RecordType::produce(myID->getName(), fields);
+	RecordType * r = RecordType::produce(name.str(), fields, fieldNames);
 	symTab->insert(new RecordSymbol(name, r));
 
 	return true;
 }
 
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string fnName = this->ID()->getName();
+	Ident fnName = this->ID()->getName();
 
 	bool validRet = myRetType->nameAnalysis(symTab);
 
-	// hold onto the scope of the function.
-	ScopeTable * atFnScope = symTab->getCurrentScope();
 	//Enter a new scope for "within" this function.
-	ScopeTable * inFnScope = symTab->enterScope();
+	symTab->enterScope();
 
 	/*Note that we check for a clash of the function 
 	  name in it's declared scope (e.g. a global
 	  scope for a global function)
 	*/
 	bool validName = true;
-	if (atFnScope->clash(fnName)){
+	if (symTab->clashEnclosing(fnName)){
 		NameErr::multiDecl(ID()->pos()); 
 		validName = false;
 	}
 
 	bool validFormals = true;
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
+	std::list<const DataType *> formalTypes;
 	for (auto formal : *(this->myFormals)){
 		validFormals = formal->nameAnalysis(symTab) && validFormals;
 		TypeNode * typeNode = formal->getTypeNode();
 		const DataType * formalType = typeNode->getType();
-		formalTypes->push_back(formalType);
+		formalTypes.push_back(formalType);
 	}
 
 
 	const DataType * retType = this->getRetTypeNode()->getType();
-	FnType * dataType = new FnType(formalTypes, retType);
+	const FnType * dataType = FnType::produce(formalTypes, retType);
 	//Make sure the fnSymbol is in the symbol table before 
 	// analyzing the body, to allow for recursive calls
 	if (validName){
-		atFnScope->addFn(fnName, dataType);
-		SemSymbol * sym = atFnScope->lookup(fnName);
+		SemSymbol * sym = new FnSymbol(fnName, dataType);
+		symTab->insertEnclosing(sym);
 		this->myID->attachSymbol(sym);
 		
 	}
@@ -276,7 +275,7 @@ bool FalseNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool IDNode::nameAnalysis(SymbolTable* symTab){
-	std::string myName = this->getName();
+	Ident myName = this->getName();
 	SemSymbol * sym = symTab->find(myName);
 	if (sym == nullptr){
 		return NameErr::undeclID(pos());
@@ -12,16 +12,20 @@ public:
 		NameAnalysis * nameAnalysis = new NameAnalysis;
 		SymbolTable * symTab = new SymbolTable();
 		bool res = astIn->nameAnalysis(symTab);
+		size_t declared = symTab->numDeclared();
 		delete symTab;
 		if (!res){ return nullptr; }
 
 		nameAnalysis->ast = astIn;
+		nameAnalysis->numSymbols = declared;
 		return nameAnalysis;
 	}
 	ProgramNode * ast;
+	//The number of symbols declared, in every scope
+	size_t numSymbols;
 
 private:
-	NameAnalysis(){
+	NameAnalysis() : numSymbols(0){
 	}
 };
 
@@ -0,0 +1,22 @@
+#include "opt.hpp"
+
+namespace cshanty{
+
+OptStats optimize(IRProgram * prog){
+	OptStats stats;
+	for (Procedure * proc : *prog->getProcs()){
+		stats.quadsBefore += proc->getBody().size();
+		stats.tempsBefore += proc->getTemps().size();
+		stats.constantsFolded += propagateConstants(proc);
+		stats.valuesReused += numberValues(proc);
+		stats.copiesPropagated += propagateCopies(proc);
+		stats.deadQuads += eliminateDeadCode(proc);
+		stats.deadTemps += proc->dropUnusedTemps();
+		stats.tempsCoalesced += coalesceTemps(proc);
+		stats.quadsAfter += proc->getBody().size();
+		stats.tempsAfter += proc->getTemps().size();
+	}
+	return stats;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef CSHANTY_OPT_HPP
+#define CSHANTY_OPT_HPP
+
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//Optimization passes over the 3AC. Each pass rewrites one
+// procedure in place and returns the number of quads it
+// changed or removed.
+
+//Conditional constant propagation: finds the variables that
+// hold a known constant on every path reaching a use, while
+// only following branches that constants leave possible.
+// Folds arithmetic and comparisons on constants, replaces
+// constant uses with literals, turns IFZs on constants into
+// gotos (or drops them) and deletes the code that becomes
+// unreachable.
+size_t propagateConstants(Procedure * proc);
+
+//Local value numbering: within each basic block, finds
+// quads that recompute a value (the same operator on
+// operands with the same value numbers) still held by some
+// operand, and turns them into copies of that operand. The
+// copies, and whatever fed the duplicates, are left for dead
+// code elimination.
+size_t numberValues(Procedure * proc);
+
+//Copy propagation: within each basic block, rewrites reads
+// of a variable copied from another variable (or a literal)
+// to read the original instead, and folds "t := <expr>;
+// x := t" into "x := <expr>" when the copy is the temp's only
+// reader. The copies left unread go to dead code elimination.
+size_t propagateCopies(Procedure * proc);
+
+//Dead code elimination: deletes quads whose results are
+// never read, as long as they have no side effects (see
+// Quad::hasSideEffects), then forgets the temps no quad
+// mentions any more.
+size_t eliminateDeadCode(Procedure * proc);
+
+//Temp coalescing: lets temps of the same width whose live
+// ranges never overlap share one slot, renaming each to the
+// first temp of its slot and deleting the copies that become
+// self-assignments. Returns the number of temps merged away.
+size_t coalesceTemps(Procedure * proc);
+
+//What the optimizer did to a program
+struct OptStats{
+	size_t quadsBefore = 0;
+	size_t quadsAfter = 0;
+	size_t tempsBefore = 0;
+	size_t tempsAfter = 0;
+	size_t constantsFolded = 0;
+	size_t valuesReused = 0;
+	size_t copiesPropagated = 0;
+	size_t deadQuads = 0;
+	size_t deadTemps = 0;
+	size_t tempsCoalesced = 0;
+};
+
+//Run every pass over each procedure in prog
+OptStats optimize(IRProgram * prog);
+
+}
+
+#endif
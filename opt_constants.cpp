@@ -0,0 +1,328 @@
+#include <deque>
+#include <limits>
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "opt.hpp"
+
+namespace cshanty{
+
+//A point in the constant propagation lattice: no value seen
+// yet, exactly one constant, or more than one value
+class ConstVal{
+public:
+	enum State : uint8_t { UNDEF, CONST, VARYING };
+
+	ConstVal() : state(UNDEF), value(0){ }
+
+	static ConstVal undef(){ return ConstVal(UNDEF, 0); }
+	static ConstVal varying(){ return ConstVal(VARYING, 0); }
+	static ConstVal constant(int64_t val){ return ConstVal(CONST, val); }
+
+	bool isConst() const { return state == CONST; }
+	bool isUndef() const { return state == UNDEF; }
+	int64_t getValue() const { return value; }
+
+	//Combine with the value arriving along another path
+	ConstVal meet(ConstVal other) const{
+		if (state == UNDEF){ return other; }
+		if (other.state == UNDEF){ return *this; }
+		if (state == CONST && other.state == CONST
+		  && value == other.value){
+			return *this;
+		}
+		return varying();
+	}
+	bool operator!=(ConstVal other) const{
+		return state != other.state || value != other.value;
+	}
+private:
+	ConstVal(State stateIn, int64_t valueIn)
+	: state(stateIn), value(valueIn){ }
+	State state;
+	int64_t value;
+};
+
+//Arithmetic wraps, as it would in a 64-bit register
+static int64_t wrap(uint64_t val){ return static_cast<int64_t>(val); }
+static uint64_t bits(int64_t val){ return static_cast<uint64_t>(val); }
+
+static ConstVal foldBinary(BinOp opr, int64_t a, int64_t b){
+	switch (opr){
+	case ADD64: return ConstVal::constant(wrap(bits(a) + bits(b)));
+	case SUB64: return ConstVal::constant(wrap(bits(a) - bits(b)));
+	case MULT64: return ConstVal::constant(wrap(bits(a) * bits(b)));
+	case DIV64:
+		//Leave faulting divisions for run time
+		if (b == 0){ return ConstVal::varying(); }
+		if (a == std::numeric_limits<int64_t>::min() && b == -1){
+			return ConstVal::varying();
+		}
+		return ConstVal::constant(a / b);
+	case EQ64: return ConstVal::constant(a == b);
+	case NEQ64: return ConstVal::constant(a != b);
+	case LT64: return ConstVal::constant(a < b);
+	case GT64: return ConstVal::constant(a > b);
+	case LTE64: return ConstVal::constant(a <= b);
+	case GTE64: return ConstVal::constant(a >= b);
+	case AND64: return ConstVal::constant(a != 0 && b != 0);
+	case OR64: return ConstVal::constant(a != 0 || b != 0);
+	}
+	throw new InternalError("Unknown binary operator");
+}
+
+static ConstVal foldUnary(UnaryOp opr, int64_t a){
+	switch (opr){
+	case NEG64: return ConstVal::constant(wrap(0 - bits(a)));
+	case NOT8: return ConstVal::constant(a == 0);
+	}
+	throw new InternalError("Unknown unary operator");
+}
+
+//The state of one run of the pass. Only variables that
+// cross blocks (Liveness slots) carry values from block to
+// block; everything else is tracked just while walking the
+// block that defines it.
+class ConstantPropagator{
+public:
+	explicit ConstantPropagator(Procedure * procIn)
+	: proc(procIn), cfg(procIn), live(cfg),
+	  ins(cfg.numBlocks()), reached(cfg.numBlocks(), false),
+	  locals(procIn->numOpds(), ConstVal::varying()),
+	  stamps(procIn->numOpds(), 0), stamp(0){ }
+
+	size_t run(){
+		solve();
+		return rewrite();
+	}
+private:
+	void solve();
+	size_t rewrite();
+	//Start walking block: values come from its in-state
+	// until the walk writes them
+	void enter(BlockID block){
+		current = block;
+		stamp++;
+	}
+	ConstVal valueOf(OpdID opd) const;
+	//The value quad gives its dst, from the current state
+	ConstVal evaluate(const Quad& quad) const;
+	void step(const Quad& quad){
+		OpdID dst = quad.getDst();
+		if (!live.isVariable(dst)){ return; }
+		locals[dst] = evaluate(quad);
+		stamps[dst] = stamp;
+	}
+	void flowTo(BlockID succ, const std::vector<ConstVal>& out,
+		std::deque<BlockID>& worklist);
+
+	Procedure * proc;
+	CFG cfg;
+	Liveness live;
+	//Values of the cross-block variables on entry to each
+	// block, by slot (empty until the block is reached)
+	std::vector<std::vector<ConstVal>> ins;
+	std::vector<bool> reached;
+	//Values written during the current block walk; a value
+	// is current if its stamp matches
+	std::vector<ConstVal> locals;
+	std::vector<uint32_t> stamps;
+	uint32_t stamp;
+	BlockID current;
+};
+
+ConstVal ConstantPropagator::valueOf(OpdID opd) const{
+	if (opd == NO_OPD){ return ConstVal::varying(); }
+	const Opd& info = proc->getOpd(opd);
+	if (info.isLit()){ return ConstVal::constant(info.getValue()); }
+	if (!live.isVariable(opd)){ return ConstVal::varying(); }
+	if (stamps[opd] == stamp){ return locals[opd]; }
+	uint32_t slot = live.slotOf(opd);
+	if (slot == Liveness::NO_SLOT){ return ConstVal::varying(); }
+	return ins[current][slot];
+}
+
+ConstVal ConstantPropagator::evaluate(const Quad& quad) const{
+	switch (quad.getOp()){
+	case QuadOp::ASSIGN:
+		return valueOf(quad.getSrc());
+	case QuadOp::BINOP: {
+		ConstVal a = valueOf(quad.getSrc1());
+		ConstVal b = valueOf(quad.getSrc2());
+		if (a.isUndef() || b.isUndef()){ return ConstVal::undef(); }
+		if (!a.isConst() || !b.isConst()){ return ConstVal::varying(); }
+		return foldBinary(quad.getBinOp(), a.getValue(), b.getValue());
+	}
+	case QuadOp::UNARYOP: {
+		ConstVal a = valueOf(quad.getSrc());
+		if (!a.isConst()){ return a; }
+		return foldUnary(quad.getUnaryOp(), a.getValue());
+	}
+	default:
+		//Input, arguments and return values are unknown
+		return ConstVal::varying();
+	}
+}
+
+void ConstantPropagator::flowTo(BlockID succ,
+	const std::vector<ConstVal>& out, std::deque<BlockID>& worklist){
+	if (!reached[succ]){
+		reached[succ] = true;
+		ins[succ] = out;
+		worklist.push_back(succ);
+		return;
+	}
+	bool changed = false;
+	std::vector<ConstVal>& in = ins[succ];
+	for (size_t s = 0; s < in.size(); s++){
+		ConstVal merged = in[s].meet(out[s]);
+		if (merged != in[s]){
+			in[s] = merged;
+			changed = true;
+		}
+	}
+	if (changed){ worklist.push_back(succ); }
+}
+
+void ConstantPropagator::solve(){
+	const std::vector<Quad>& body = proc->getBody();
+	size_t slots = live.numSlots();
+
+	//Nothing is known about variables on entry
+	reached[cfg.entry()] = true;
+	ins[cfg.entry()].assign(slots, ConstVal::varying());
+	std::deque<BlockID> worklist;
+	worklist.push_back(cfg.entry());
+
+	std::vector<ConstVal> out(slots);
+	while (!worklist.empty()){
+		BlockID block = worklist.front();
+		worklist.pop_front();
+
+		enter(block);
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			step(body[i]);
+		}
+		for (uint32_t s = 0; s < slots; s++){
+			out[s] = valueOf(live.opdOfSlot(s));
+		}
+
+		if (block == cfg.exit()){ continue; }
+		//Only follow the branches the condition allows
+		const Quad& last = body[cfg.end(block) - 1];
+		BlockRange succs = cfg.succs(block);
+		if (last.getOp() == QuadOp::IFZ && succs.size() == 2){
+			ConstVal cond = valueOf(last.getSrc());
+			if (cond.isUndef()){ continue; }
+			if (cond.isConst()){
+				BlockID taken = cond.getValue() == 0 ? succs[1] : succs[0];
+				flowTo(taken, out, worklist);
+				continue;
+			}
+		}
+		for (BlockID succ : succs){
+			flowTo(succ, out, worklist);
+		}
+	}
+}
+
+size_t ConstantPropagator::rewrite(){
+	std::vector<Quad>& body = proc->getBody();
+	std::vector<bool> dead(body.size(), false);
+	size_t changes = 0;
+
+	//Replace a use by a literal if it is a known constant
+	auto literal = [&](OpdID opd){
+		ConstVal val = valueOf(opd);
+		if (!val.isConst() || proc->getOpd(opd).isLit()){ return opd; }
+		return proc->makeLit(val.getValue(), proc->getOpd(opd).getWidth());
+	};
+
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		if (!reached[block]){
+			for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+				dead[i] = true;
+				changes++;
+			}
+			continue;
+		}
+
+		enter(block);
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			Quad quad = body[i];
+			OpdID dst = quad.getDst();
+			switch (quad.getOp()){
+			case QuadOp::ASSIGN:
+			case QuadOp::BINOP:
+			case QuadOp::UNARYOP: {
+				ConstVal res = evaluate(quad);
+				if (res.isConst() && live.isVariable(dst)){
+					OpdID lit = proc->makeLit(res.getValue(),
+						proc->getOpd(dst).getWidth());
+					if (quad.getOp() != QuadOp::ASSIGN || quad.getSrc() != lit){
+						proc->replaceQuad(i, AssignQuad(dst, lit));
+						changes++;
+					}
+				} else if (quad.getOp() == QuadOp::BINOP){
+					OpdID a = literal(quad.getSrc1());
+					OpdID b = literal(quad.getSrc2());
+					if (a != quad.getSrc1() || b != quad.getSrc2()){
+						proc->replaceQuad(i,
+							BinOpQuad(dst, quad.getBinOp(), a, b));
+						changes++;
+					}
+				} else if (quad.getOp() == QuadOp::UNARYOP){
+					OpdID a = literal(quad.getSrc());
+					if (a != quad.getSrc()){
+						proc->replaceQuad(i,
+							UnaryOpQuad(dst, quad.getUnaryOp(), a));
+						changes++;
+					}
+				}
+				break;
+			}
+			case QuadOp::IFZ: {
+				ConstVal cond = valueOf(quad.getSrc());
+				if (cond.isConst()){
+					if (cond.getValue() == 0){
+						proc->replaceQuad(i, GotoQuad(quad.getTarget()));
+					} else {
+						dead[i] = true;
+					}
+					changes++;
+				}
+				break;
+			}
+			case QuadOp::REPORT:
+			case QuadOp::SETARG:
+			case QuadOp::SETRET: {
+				OpdID src = literal(quad.getSrc());
+				if (src == quad.getSrc()){ break; }
+				if (quad.getOp() == QuadOp::REPORT){
+					proc->replaceQuad(i, ReportQuad(src, quad.getType()));
+				} else if (quad.getOp() == QuadOp::SETARG){
+					proc->replaceQuad(i, SetArgQuad(quad.getIndex(), src));
+				} else {
+					proc->replaceQuad(i, SetRetQuad(src));
+				}
+				changes++;
+				break;
+			}
+			default:
+				break;
+			}
+			//Advance past the original quad, which computes the
+			// same value as its replacement
+			step(quad);
+		}
+	}
+
+	proc->removeQuads(dead);
+	return changes;
+}
+
+size_t propagateConstants(Procedure * proc){
+	ConstantPropagator pass(proc);
+	return pass.run();
+}
+
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "opt.hpp"
+
+namespace cshanty{
+
+//Whether a quad reads src1 as a value (CALL names its callee
+// and INDEX its base by location instead)
+static bool readsSrc1(const Quad& quad){
+	return quad.getOp() != QuadOp::CALL && quad.getOp() != QuadOp::INDEX;
+}
+
+//Whether a quad computes its dst in a way that can write
+// any variable instead
+static bool retargetable(const Quad& quad){
+	switch (quad.getOp()){
+	case QuadOp::ASSIGN:
+	case QuadOp::BINOP:
+	case QuadOp::UNARYOP:
+	case QuadOp::RECEIVE:
+	case QuadOp::GETARG:
+	case QuadOp::GETRET:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//Within each block, replace reads of a variable that was
+// copied from another variable (or a literal) with reads of
+// the original, as long as neither has been written since
+static size_t forwardCopies(Procedure * proc, const CFG& cfg,
+	const Liveness& live){
+	std::vector<Quad>& body = proc->getBody();
+	size_t numOpds = proc->numOpds();
+	//For each variable: the operand it was last copied from,
+	// that operand's version at the time, and the block
+	// walk the copy was recorded in
+	std::vector<OpdID> copySrc(numOpds, NO_OPD);
+	std::vector<uint32_t> copyVersion(numOpds, 0);
+	std::vector<uint32_t> copyStamp(numOpds, 0);
+	//Bumped on every write to a variable
+	std::vector<uint32_t> versions(numOpds, 0);
+	uint32_t stamp = 0;
+	size_t rewritten = 0;
+
+	auto original = [&](OpdID opd){
+		if (!live.isVariable(opd) || copyStamp[opd] != stamp){ return opd; }
+		OpdID src = copySrc[opd];
+		if (live.isVariable(src) && versions[src] != copyVersion[opd]){
+			return opd;
+		}
+		return src;
+	};
+
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		stamp++;
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			Quad& quad = body[i];
+			if (readsSrc1(quad) && quad.getSrc1() != NO_OPD){
+				OpdID src = original(quad.getSrc1());
+				if (src != quad.getSrc1()){
+					quad.setSrc1(src);
+					rewritten++;
+				}
+			}
+			if (quad.getSrc2() != NO_OPD){
+				OpdID src = original(quad.getSrc2());
+				if (src != quad.getSrc2()){
+					quad.setSrc2(src);
+					rewritten++;
+				}
+			}
+
+			OpdID dst = quad.getDst();
+			if (!live.isVariable(dst)){ continue; }
+			versions[dst]++;
+			copyStamp[dst] = 0;
+			if (quad.getOp() != QuadOp::ASSIGN){ continue; }
+			OpdID src = quad.getSrc();
+			if (src != dst && (live.isVariable(src)
+			  || proc->getOpd(src).isLit())){
+				copySrc[dst] = src;
+				copyVersion[dst] = live.isVariable(src) ? versions[src] : 0;
+				copyStamp[dst] = stamp;
+			}
+		}
+	}
+	return rewritten;
+}
+
+//Within each block, fold "t := <expr>; x := t" into
+// "x := <expr>" when that copy is the only read of the temp
+// and x isn't touched in between
+static size_t retargetCopies(Procedure * proc, const CFG& cfg,
+	const Liveness& live, std::vector<bool>& dead){
+	std::vector<Quad>& body = proc->getBody();
+	size_t numOpds = proc->numOpds();
+	const size_t NONE = SIZE_MAX;
+
+	//How many times the value written by each quad is read
+	// (only counted for temps that never cross blocks)
+	std::vector<uint32_t> reads(body.size(), 0);
+	std::vector<size_t> lastDef(numOpds, NONE);
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			const Quad& quad = body[i];
+			for (OpdID src : {quad.getSrc1(), quad.getSrc2()}){
+				if (live.isVariable(src) && lastDef[src] != NONE){
+					reads[lastDef[src]]++;
+				}
+			}
+			OpdID dst = quad.getDst();
+			if (live.isVariable(dst)){ lastDef[dst] = i; }
+		}
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			OpdID dst = body[i].getDst();
+			if (dst != NO_OPD){ lastDef[dst] = NONE; }
+		}
+	}
+
+	std::vector<size_t> lastTouch(numOpds, NONE);
+	size_t folded = 0;
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		size_t lastCall = NONE;
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			const Quad& quad = body[i];
+			OpdID tmp = quad.getSrc();
+			OpdID dst = quad.getDst();
+			size_t def = tmp == NO_OPD ? NONE : lastDef[tmp];
+			bool fold = quad.getOp() == QuadOp::ASSIGN
+				&& def != NONE && reads[def] == 1
+				&& proc->getOpd(tmp).getKind() == OpdKind::TMP
+				&& live.slotOf(tmp) == Liveness::NO_SLOT
+				&& retargetable(body[def])
+				//(the def itself may read x, as in t := x + 1)
+				&& (lastTouch[dst] == NONE || lastTouch[dst] <= def)
+				//Writing memory earlier must not cross a call
+				&& (live.isVariable(dst) || lastCall == NONE
+				  || lastCall < def);
+			if (fold){
+				body[def].setDst(dst);
+				dead[i] = true;
+				lastTouch[dst] = i;
+				//def now writes dst, and its readers are the copy's
+				if (live.isVariable(dst)){
+					lastDef[dst] = def;
+					reads[def] = reads[i];
+				}
+				folded++;
+				continue;
+			}
+
+			if (quad.getOp() == QuadOp::CALL){ lastCall = i; }
+			for (OpdID opd : {quad.getSrc1(), quad.getSrc2(), dst}){
+				if (opd != NO_OPD){ lastTouch[opd] = i; }
+			}
+			if (live.isVariable(dst)){ lastDef[dst] = i; }
+		}
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			const Quad& quad = body[i];
+			for (OpdID opd : {quad.getSrc1(), quad.getSrc2(), quad.getDst()}){
+				if (opd != NO_OPD){
+					lastTouch[opd] = NONE;
+					lastDef[opd] = NONE;
+				}
+			}
+		}
+	}
+	return folded;
+}
+
+size_t propagateCopies(Procedure * proc){
+	//Folding first keeps "x := t" from being propagated into
+	// t's readers, which would leave t too many to fold
+	size_t changes = 0;
+	{
+		CFG cfg(proc);
+		Liveness live(cfg);
+		std::vector<bool> dead(proc->getBody().size(), false);
+		changes += retargetCopies(proc, cfg, live, dead);
+		proc->removeQuads(dead);
+	}
+	CFG cfg(proc);
+	Liveness live(cfg);
+	changes += forwardCopies(proc, cfg, live);
+	return changes;
+}
+
+size_t coalesceTemps(Procedure * proc){
+	CFG cfg(proc);
+	Liveness live(cfg);
+	std::vector<Quad>& body = proc->getBody();
+	const std::vector<OpdID>& temps = proc->getTemps();
+
+	//Number the temps densely, in the order they were made
+	const uint32_t NOT_TEMP = UINT32_MAX;
+	std::vector<uint32_t> tempIdx(proc->numOpds(), NOT_TEMP);
+	for (size_t t = 0; t < temps.size(); t++){
+		tempIdx[temps[t]] = static_cast<uint32_t>(t);
+	}
+
+	//Build the interference graph: a temp interferes with
+	// every temp live where it is written, except the one it
+	// is copied from. The live temps are kept in a list with
+	// each one's position, so adding and removing are O(1).
+	std::vector<std::vector<uint32_t>> adjacent(temps.size());
+	std::vector<uint32_t> liveList;
+	std::vector<uint32_t> livePos(temps.size(), NOT_TEMP);
+	auto makeLive = [&](uint32_t t){
+		if (livePos[t] != NOT_TEMP){ return; }
+		livePos[t] = static_cast<uint32_t>(liveList.size());
+		liveList.push_back(t);
+	};
+	auto makeDead = [&](uint32_t t){
+		uint32_t pos = livePos[t];
+		if (pos == NOT_TEMP){ return; }
+		uint32_t moved = liveList.back();
+		liveList[pos] = moved;
+		livePos[moved] = pos;
+		liveList.pop_back();
+		livePos[t] = NOT_TEMP;
+	};
+
+	for (BlockID block : cfg.rpo()){
+		live.liveOut(block).forEach([&](size_t slot){
+			OpdID opd = live.opdOfSlot(static_cast<uint32_t>(slot));
+			if (tempIdx[opd] != NOT_TEMP){ makeLive(tempIdx[opd]); }
+		});
+		for (size_t i = cfg.end(block); i-- > cfg.first(block); ){
+			const Quad& quad = body[i];
+			OpdID dst = quad.getDst();
+			if (dst != NO_OPD && tempIdx[dst] != NOT_TEMP){
+				uint32_t t = tempIdx[dst];
+				uint32_t copied = NOT_TEMP;
+				if (quad.getOp() == QuadOp::ASSIGN){
+					copied = tempIdx[quad.getSrc()];
+				}
+				for (uint32_t other : liveList){
+					if (other == t || other == copied){ continue; }
+					adjacent[t].push_back(other);
+					adjacent[other].push_back(t);
+				}
+				makeDead(t);
+			}
+			for (OpdID src : {quad.getSrc1(), quad.getSrc2()}){
+				if (src != NO_OPD && tempIdx[src] != NOT_TEMP){
+					makeLive(tempIdx[src]);
+				}
+			}
+		}
+		while (!liveList.empty()){ makeDead(liveList.back()); }
+	}
+
+	//Greedily give each temp the first slot none of its
+	// neighbors has. Each slot is named by its first temp.
+	std::vector<uint32_t> colors(temps.size(), NOT_TEMP);
+	std::vector<OpdID> slotTemps;
+	std::vector<uint32_t> taken;
+	uint32_t stamp = 0;
+	for (uint32_t t = 0; t < temps.size(); t++){
+		stamp++;
+		for (uint32_t other : adjacent[t]){
+			if (colors[other] != NOT_TEMP){ taken[colors[other]] = stamp; }
+		}
+		uint32_t color = 0;
+		size_t width = proc->getOpd(temps[t]).getWidth();
+		while (color < slotTemps.size() && (taken[color] == stamp
+		  || proc->getOpd(slotTemps[color]).getWidth() != width)){
+			color++;
+		}
+		if (color == slotTemps.size()){
+			slotTemps.push_back(temps[t]);
+			taken.push_back(0);
+		}
+		colors[t] = color;
+	}
+
+	size_t merged = temps.size() - slotTemps.size();
+	if (merged == 0){ return 0; }
+
+	auto rename = [&](OpdID opd){
+		if (opd == NO_OPD || tempIdx[opd] == NOT_TEMP){ return opd; }
+		return slotTemps[colors[tempIdx[opd]]];
+	};
+	std::vector<bool> dead(body.size(), false);
+	for (size_t i = 0; i < body.size(); i++){
+		Quad& quad = body[i];
+		quad.setDst(rename(quad.getDst()));
+		quad.setSrc1(rename(quad.getSrc1()));
+		quad.setSrc2(rename(quad.getSrc2()));
+		//Copies between merged temps now do nothing
+		if (quad.getOp() == QuadOp::ASSIGN && quad.getDst() == quad.getSrc()){
+			dead[i] = true;
+		}
+	}
+	proc->removeQuads(dead);
+	proc->dropUnusedTemps();
+	return merged;
+}
+
+}
@@ -0,0 +1,75 @@
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "opt.hpp"
+
+namespace cshanty{
+
+//Whether quad may be deleted if its result is never read
+static bool removable(const Quad& quad, const Procedure * proc){
+	if (quad.hasSideEffects()){ return false; }
+	//Keep divisions that might fault
+	if (quad.getOp() == QuadOp::BINOP && quad.getBinOp() == DIV64){
+		const Opd& divisor = proc->getOpd(quad.getSrc2());
+		return divisor.isLit() && divisor.getValue() != 0
+			&& divisor.getValue() != -1;
+	}
+	return true;
+}
+
+//One sweep: delete the quads whose results are dead, using
+// liveness computed before the sweep. Each block is walked
+// backward from its live-out set, so a chain of dead quads
+// within a block goes in one sweep.
+static size_t sweepDeadCode(Procedure * proc){
+	CFG cfg(proc);
+	Liveness live(cfg);
+	const std::vector<Quad>& body = proc->getBody();
+	std::vector<bool> dead(body.size(), false);
+	size_t removed = 0;
+
+	//A variable is live while its stamp matches the block's
+	std::vector<uint32_t> liveStamp(proc->numOpds(), 0);
+	uint32_t stamp = 0;
+	for (BlockID block : cfg.rpo()){
+		stamp++;
+		live.liveOut(block).forEach([&](size_t slot){
+			liveStamp[live.opdOfSlot(static_cast<uint32_t>(slot))] = stamp;
+		});
+
+		for (size_t i = cfg.end(block); i-- > cfg.first(block); ){
+			const Quad& quad = body[i];
+			OpdID dst = quad.getDst();
+			bool wanted = !live.isVariable(dst) || liveStamp[dst] == stamp;
+			if (quad.getOp() == QuadOp::NOP){
+				//A label may be a jump target, so it has to stay
+				wanted = quad.getLabel() != NO_LABEL;
+			}
+			if (!wanted && removable(quad, proc)){
+				dead[i] = true;
+				removed++;
+				continue;
+			}
+			if (live.isVariable(dst)){ liveStamp[dst] = 0; }
+			for (OpdID src : {quad.getSrc1(), quad.getSrc2()}){
+				if (live.isVariable(src)){ liveStamp[src] = stamp; }
+			}
+		}
+	}
+
+	if (removed > 0){ proc->removeQuads(dead); }
+	return removed;
+}
+
+size_t eliminateDeadCode(Procedure * proc){
+	//Deleting a quad can leave the quads feeding it dead in
+	// other blocks, so sweep until nothing changes
+	size_t total = 0;
+	while (true){
+		size_t removed = sweepDeadCode(proc);
+		if (removed == 0){ break; }
+		total += removed;
+	}
+	return total;
+}
+
+}
@@ -0,0 +1,162 @@
+#include <unordered_map>
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "opt.hpp"
+
+namespace cshanty{
+
+//An expression as value numbering sees it: an operator
+// applied to the value numbers of its operands
+struct ExprKey{
+	QuadOp op;
+	uint8_t opr;
+	uint32_t lhs;
+	uint32_t rhs;
+
+	bool operator==(const ExprKey& other) const{
+		return op == other.op && opr == other.opr
+			&& lhs == other.lhs && rhs == other.rhs;
+	}
+};
+
+struct ExprKeyHash{
+	size_t operator()(const ExprKey& key) const{
+		uint64_t h = static_cast<uint64_t>(key.op) << 8 | key.opr;
+		h = h * 0x9E3779B97F4A7C15ull ^ key.lhs;
+		h = h * 0x9E3779B97F4A7C15ull ^ key.rhs;
+		return static_cast<size_t>(h ^ (h >> 29));
+	}
+};
+
+static bool commutes(BinOp opr){
+	switch (opr){
+	case ADD64: case MULT64: case EQ64: case NEQ64:
+	case AND64: case OR64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//The state of one run of the pass
+class ValueNumberer{
+public:
+	explicit ValueNumberer(Procedure * procIn)
+	: proc(procIn), cfg(procIn), live(cfg),
+	  opdVNs(procIn->numOpds(), 0), opdStamps(procIn->numOpds(), 0),
+	  stamp(0), nextVN(1){ }
+
+	size_t run(){
+		size_t replaced = 0;
+		for (BlockID block = 0; block < cfg.numBlocks(); block++){
+			replaced += numberBlock(block);
+		}
+		return replaced;
+	}
+private:
+	size_t numberBlock(BlockID block);
+	//The value number opd holds at this point in the block.
+	// Literals keep theirs for the whole procedure; anything
+	// else read before being written here gets a fresh one.
+	uint32_t vnOf(OpdID opd){
+		if (opdStamps[opd] != stamp && !proc->getOpd(opd).isLit()){
+			setVN(opd, nextVN++);
+		} else if (opdVNs[opd] == 0){
+			opdVNs[opd] = nextVN++;
+		}
+		return opdVNs[opd];
+	}
+	void setVN(OpdID opd, uint32_t vn){
+		opdVNs[opd] = vn;
+		opdStamps[opd] = stamp;
+		if (!live.isVariable(opd)){ memory.push_back(opd); }
+	}
+
+	Procedure * proc;
+	CFG cfg;
+	Liveness live;
+	std::vector<uint32_t> opdVNs;
+	//The block walk each opdVNs entry belongs to
+	std::vector<uint32_t> opdStamps;
+	uint32_t stamp;
+	uint32_t nextVN;
+	//The value computed by each expression seen in the block,
+	// and an operand that held it
+	struct Holder{
+		uint32_t vn;
+		OpdID opd;
+	};
+	std::unordered_map<ExprKey, Holder, ExprKeyHash> exprs;
+	//Globals (and other memory) given numbers in this block;
+	// a call may change any of them
+	std::vector<OpdID> memory;
+};
+
+size_t ValueNumberer::numberBlock(BlockID block){
+	std::vector<Quad>& body = proc->getBody();
+	stamp++;
+	exprs.clear();
+	memory.clear();
+	size_t replaced = 0;
+
+	for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+		Quad quad = body[i];
+		OpdID dst = quad.getDst();
+		switch (quad.getOp()){
+		case QuadOp::ASSIGN:
+			setVN(dst, vnOf(quad.getSrc()));
+			break;
+		case QuadOp::BINOP:
+		case QuadOp::UNARYOP: {
+			ExprKey key;
+			key.op = quad.getOp();
+			key.lhs = vnOf(quad.getSrc1());
+			key.rhs = 0;
+			if (quad.getOp() == QuadOp::BINOP){
+				key.opr = static_cast<uint8_t>(quad.getBinOp());
+				key.rhs = vnOf(quad.getSrc2());
+				if (commutes(quad.getBinOp()) && key.rhs < key.lhs){
+					std::swap(key.lhs, key.rhs);
+				}
+			} else {
+				key.opr = static_cast<uint8_t>(quad.getUnaryOp());
+			}
+
+			auto found = exprs.find(key);
+			//The holder must still hold the value; it may have
+			// been overwritten since
+			if (found != exprs.end()
+			  && opdStamps[found->second.opd] == stamp
+			  && opdVNs[found->second.opd] == found->second.vn){
+				proc->replaceQuad(i, AssignQuad(dst, found->second.opd));
+				setVN(dst, found->second.vn);
+				replaced++;
+			} else {
+				uint32_t vn = nextVN++;
+				setVN(dst, vn);
+				Holder holder;
+				holder.vn = vn;
+				holder.opd = dst;
+				exprs[key] = holder;
+			}
+			break;
+		}
+		case QuadOp::CALL:
+			for (OpdID opd : memory){ opdStamps[opd] = 0; }
+			memory.clear();
+			break;
+		default:
+			//Input, arguments and return values are new values
+			if (dst != NO_OPD){ setVN(dst, nextVN++); }
+			break;
+		}
+	}
+	return replaced;
+}
+
+size_t numberValues(Procedure * proc){
+	ValueNumberer pass(proc);
+	return pass.run();
+}
+
+}
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include "position.hpp"
+
+namespace cshanty{
+
+thread_local SourceMap * SourceMap::current = nullptr;
+
+SourceMap::SourceMap() : prev(current){
+	lineStarts.push_back(0);
+	current = this;
+}
+
+SourceMap::~SourceMap(){
+	if (current == this){ current = prev; }
+}
+
+void SourceMap::decode(uint32_t offset, size_t& line, size_t& col) const{
+	//Find the last line that starts at or before offset
+	auto itr = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+	size_t lineIdx = static_cast<size_t>(itr - lineStarts.begin());
+	line = lineIdx;
+	col = offset - lineStarts[lineIdx - 1] + 1;
+}
+
+static std::string formatOffset(uint32_t offset){
+	size_t line = 1;
+	size_t col = offset + 1;
+	const SourceMap * map = SourceMap::active();
+	if (map != nullptr){
+		map->decode(offset, line, col);
+	}
+	return "["
+		+ std::to_string(line)
+		+ ","
+		+ std::to_string(col)
+		+ "]";
+}
+
+std::string Position::begin() const{
+	return formatOffset(myStart);
+}
+
+std::string Position::span() const{
+	return begin() + "-" + formatOffset(myEnd);
+}
+
+}
@@ -1,48 +1,65 @@
 #ifndef CSHANTY_POSITION_H
 #define CSHANTY_POSITION_H
 
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace cshanty{
 
-class Position{
-public: 
-	Position(size_t lineI, size_t colI, size_t lineE, size_t colE)
-	: myLineI(lineI), myColI(colI), myLineE(lineE), myColE(colE){
-	}
-	Position(Position * start, Position * end)
-	: myLineI(start->myLineI), myColI(start->myColI),
-	  myLineE(end->myLineE),myColE(end->myColE){
+//Records where each line of the source being compiled
+// starts, so that a byte offset can be turned back into a
+// line and column. The scanner fills this in as it consumes
+// newlines; nothing else needs line numbers until a
+// diagnostic is actually printed.
+//
+//The most recently constructed SourceMap on a thread is 
+// the active one for that thread, and is what Position
+// decodes itself against.
+class SourceMap{
+public:
+	SourceMap();
+	~SourceMap();
+	SourceMap(const SourceMap&) = delete;
+	SourceMap& operator=(const SourceMap&) = delete;
+
+	//Note that a new line begins at the given offset
+	void addLine(uint32_t offset){
+		lineStarts.push_back(offset);
 	}
-	virtual void expand(Position * start, Position * end){
-	  myLineI = start->myLineI;
-	  myColI = start->myColI;
-	  myLineE = end->myLineE;
-	  myColE = end->myColE;
+	//Lines and columns are both 1-based
+	void decode(uint32_t offset, size_t& line, size_t& col) const;
+
+	static const SourceMap * active(){ return current; }
+private:
+	std::vector<uint32_t> lineStarts;
+	SourceMap * prev;
+	static thread_local SourceMap * current;
+};
+
+//A source range, stored as a pair of byte offsets into the
+// input. Line and column numbers are only computed when the
+// position is printed.
+class Position{
+public:
+	Position() : myStart(0), myEnd(0){ }
+	Position(uint32_t start, uint32_t end)
+	: myStart(start), myEnd(end){
 	}
-	virtual std::string begin() const{
-		std::string result = "[" 
-		+ std::to_string(myLineI)
-		+ "," 
-		+ std::to_string(myColI)
-		+ "]";
-		return result;
+	Position(Position start, Position end)
+	: myStart(start.myStart), myEnd(end.myEnd){
 	}
-	virtual std::string span() const{
-		std::string result = begin()
-		+ "-[" 
-		+ std::to_string(myLineE)
-		+ "," 
-		+ std::to_string(myColE)
-		+ "]";
-		return result;
+	void expand(Position start, Position end){
+		myStart = start.myStart;
+		myEnd = end.myEnd;
 	}
+	uint32_t startOffset() const { return myStart; }
+	uint32_t endOffset() const { return myEnd; }
+	std::string begin() const;
+	std::string span() const;
 private:
-	size_t myLineI;
-	size_t myColI;
-	size_t myLineE;
-	size_t myColE;
-
+	uint32_t myStart;
+	uint32_t myEnd;
 };
 
 }
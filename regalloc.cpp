@@ -0,0 +1,473 @@
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <set>
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "regalloc.hpp"
+
+namespace cshanty{
+
+static const uint32_t NO_REG = UINT32_MAX;
+static const uint32_t NOT_VAR = UINT32_MAX;
+
+RegAllocStats& RegAllocStats::operator+=(const RegAllocStats& other){
+	variables += other.variables;
+	inRegisters += other.inRegisters;
+	spilled += other.spilled;
+	spillQuads += other.spillQuads;
+	reloadQuads += other.reloadQuads;
+	slotsBefore += other.slotsBefore;
+	slotsAfter += other.slotsAfter;
+	colored += other.colored;
+	return *this;
+}
+
+//Whether no register keeps its value past quad
+static bool clobbers(const Quad& quad){
+	switch (quad.getOp()){
+	case QuadOp::CALL:
+	case QuadOp::REPORT:
+	case QuadOp::RECEIVE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//Allocates registers for one procedure. Variables are
+// numbered densely, and a quad at body index i reads its
+// sources at position 2i and writes its dst at 2i+1.
+class RegAllocator{
+public:
+	RegAllocator(Procedure * procIn, size_t numRegsIn);
+	RegAllocStats run();
+private:
+	void findVariables();
+	void findIntervals();
+	//Walk each block backward to find which variables are
+	// live across each clobbering quad, and (if graph is
+	// set) which variables interfere
+	void walkLiveness(bool graph);
+	//Assign registers into regs (NO_REG for memory),
+	// returning the reads and writes left in memory
+	size_t linearScan(std::vector<uint32_t>& regs) const;
+	size_t colorGraph(std::vector<uint32_t>& regs) const;
+	size_t costOf(const std::vector<uint32_t>& regs) const;
+	//Insert the spills and reloads around clobbering quads
+	// and put the registers in place of the variables
+	void rewrite(const std::vector<uint32_t>& regs, RegAllocStats& stats);
+
+	uint32_t varOf(OpdID opd) const {
+		return opd == NO_OPD || opd >= varIdx.size() ? NOT_VAR : varIdx[opd];
+	}
+
+	Procedure * proc;
+	uint32_t numRegs;
+	CFG cfg;
+	Liveness live;
+	std::vector<uint32_t> varIdx;
+	std::vector<OpdID> vars;
+	//How often each variable is read or written
+	std::vector<size_t> weights;
+	//Each variable's live interval, as first and last position
+	std::vector<size_t> starts;
+	std::vector<size_t> ends;
+	std::vector<std::vector<uint32_t>> adjacent;
+	//The clobbering quads, in body order, and the variables
+	// live across each
+	std::vector<size_t> clobberQuads;
+	std::vector<std::vector<uint32_t>> across;
+};
+
+RegAllocator::RegAllocator(Procedure * procIn, size_t numRegsIn)
+: proc(procIn), numRegs(static_cast<uint32_t>(numRegsIn)),
+  cfg(procIn), live(cfg){ }
+
+void RegAllocator::findVariables(){
+	varIdx.assign(proc->numOpds(), NOT_VAR);
+	for (const Quad& quad : proc->getBody()){
+		if (quad.getOp() == QuadOp::PHI){
+			throw new InternalError("Register allocation in SSA form");
+		}
+		for (OpdID opd : {quad.getDst(), quad.getSrc1(), quad.getSrc2()}){
+			if (opd == NO_OPD || !live.isVariable(opd)){ continue; }
+			if (varIdx[opd] == NOT_VAR){
+				varIdx[opd] = static_cast<uint32_t>(vars.size());
+				vars.push_back(opd);
+				weights.push_back(0);
+			}
+			weights[varIdx[opd]]++;
+		}
+	}
+}
+
+void RegAllocator::findIntervals(){
+	starts.assign(vars.size(), SIZE_MAX);
+	ends.assign(vars.size(), 0);
+	auto extend = [&](uint32_t var, size_t pos){
+		starts[var] = std::min(starts[var], pos);
+		ends[var] = std::max(ends[var], pos);
+	};
+	const std::vector<Quad>& body = proc->getBody();
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		size_t first = cfg.first(block);
+		size_t end = cfg.end(block);
+		if (first == end){ continue; }
+		//A variable live on entry or exit is live over the
+		// whole start or end of the block
+		live.liveIn(block).forEach([&](size_t slot){
+			OpdID opd = live.opdOfSlot(static_cast<uint32_t>(slot));
+			if (varOf(opd) != NOT_VAR){ extend(varOf(opd), 2 * first); }
+		});
+		live.liveOut(block).forEach([&](size_t slot){
+			OpdID opd = live.opdOfSlot(static_cast<uint32_t>(slot));
+			if (varOf(opd) != NOT_VAR){ extend(varOf(opd), 2 * end - 1); }
+		});
+		for (size_t i = first; i < end; i++){
+			const Quad& quad = body[i];
+			for (OpdID src : {quad.getSrc1(), quad.getSrc2()}){
+				if (varOf(src) != NOT_VAR){ extend(varOf(src), 2 * i); }
+			}
+			if (varOf(quad.getDst()) != NOT_VAR){
+				extend(varOf(quad.getDst()), 2 * i + 1);
+			}
+		}
+	}
+}
+
+void RegAllocator::walkLiveness(bool graph){
+	clobberQuads.clear();
+	across.clear();
+	if (graph){ adjacent.assign(vars.size(), std::vector<uint32_t>()); }
+
+	//The live variables are kept in a list with each one's
+	// position, so adding and removing are O(1)
+	std::vector<uint32_t> liveList;
+	std::vector<uint32_t> livePos(vars.size(), NOT_VAR);
+	auto makeLive = [&](uint32_t var){
+		if (var == NOT_VAR || livePos[var] != NOT_VAR){ return; }
+		livePos[var] = static_cast<uint32_t>(liveList.size());
+		liveList.push_back(var);
+	};
+	auto makeDead = [&](uint32_t var){
+		if (var == NOT_VAR || livePos[var] == NOT_VAR){ return; }
+		uint32_t pos = livePos[var];
+		uint32_t moved = liveList.back();
+		liveList[pos] = moved;
+		livePos[moved] = pos;
+		liveList.pop_back();
+		livePos[var] = NOT_VAR;
+	};
+
+	const std::vector<Quad>& body = proc->getBody();
+	std::vector<std::pair<size_t, std::vector<uint32_t>>> found;
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		live.liveOut(block).forEach([&](size_t slot){
+			makeLive(varOf(live.opdOfSlot(static_cast<uint32_t>(slot))));
+		});
+		for (size_t i = cfg.end(block); i-- > cfg.first(block); ){
+			const Quad& quad = body[i];
+			uint32_t dst = varOf(quad.getDst());
+			if (clobbers(quad)){
+				std::vector<uint32_t> survivors;
+				for (uint32_t var : liveList){
+					if (var != dst){ survivors.push_back(var); }
+				}
+				found.emplace_back(i, std::move(survivors));
+			}
+			if (dst != NOT_VAR){
+				if (graph){
+					for (uint32_t other : liveList){
+						if (other == dst){ continue; }
+						adjacent[dst].push_back(other);
+						adjacent[other].push_back(dst);
+					}
+				}
+				makeDead(dst);
+			}
+			makeLive(varOf(quad.getSrc1()));
+			makeLive(varOf(quad.getSrc2()));
+		}
+		while (!liveList.empty()){ makeDead(liveList.back()); }
+	}
+
+	std::sort(found.begin(), found.end(),
+		[](const std::pair<size_t, std::vector<uint32_t>>& a,
+		  const std::pair<size_t, std::vector<uint32_t>>& b){
+			return a.first < b.first;
+		});
+	for (auto& entry : found){
+		clobberQuads.push_back(entry.first);
+		across.push_back(std::move(entry.second));
+	}
+	if (graph){
+		for (std::vector<uint32_t>& neighbors : adjacent){
+			std::sort(neighbors.begin(), neighbors.end());
+			neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+				neighbors.end());
+		}
+	}
+}
+
+size_t RegAllocator::costOf(const std::vector<uint32_t>& regs) const{
+	size_t cost = 0;
+	for (uint32_t var = 0; var < vars.size(); var++){
+		if (regs[var] == NO_REG){ cost += weights[var]; }
+	}
+	return cost;
+}
+
+//Poletto and Sarkar's linear scan: visit the intervals by
+// start, retiring those that have ended; when every register
+// is taken, whichever interval ends last goes to memory
+size_t RegAllocator::linearScan(std::vector<uint32_t>& regs) const{
+	regs.assign(vars.size(), NO_REG);
+	std::vector<uint32_t> order(vars.size());
+	for (uint32_t var = 0; var < vars.size(); var++){ order[var] = var; }
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+		return starts[a] != starts[b] ? starts[a] < starts[b] : a < b;
+	});
+
+	std::vector<uint32_t> freeRegs;
+	for (uint32_t reg = numRegs; reg-- > 0; ){ freeRegs.push_back(reg); }
+	//The intervals holding a register, by end
+	std::set<std::pair<size_t, uint32_t>> active;
+	for (uint32_t var : order){
+		while (!active.empty() && active.begin()->first < starts[var]){
+			freeRegs.push_back(regs[active.begin()->second]);
+			active.erase(active.begin());
+		}
+		if (!freeRegs.empty()){
+			regs[var] = freeRegs.back();
+			freeRegs.pop_back();
+			active.emplace(ends[var], var);
+			continue;
+		}
+		if (active.empty()){ continue; }
+		auto last = std::prev(active.end());
+		if (last->first > ends[var]){
+			regs[var] = regs[last->second];
+			regs[last->second] = NO_REG;
+			active.erase(last);
+			active.emplace(ends[var], var);
+		}
+	}
+	return costOf(regs);
+}
+
+//Chaitin's simplify and select, with Briggs' optimistic
+// coloring: variables with fewer neighbors than there are
+// registers are set aside first; when none is left, the one
+// cheapest to leave in memory per neighbor is set aside
+// anyway, in the hope its neighbors end up sharing colors.
+// Colors are then handed out in the reverse order.
+size_t RegAllocator::colorGraph(std::vector<uint32_t>& regs) const{
+	size_t count = vars.size();
+	regs.assign(count, NO_REG);
+	std::vector<size_t> degree(count);
+	std::vector<bool> removed(count, false);
+	std::vector<uint32_t> low;
+	for (uint32_t var = 0; var < count; var++){
+		degree[var] = adjacent[var].size();
+		if (degree[var] < numRegs){ low.push_back(var); }
+	}
+	//Candidates for optimistic removal, cheapest first. A
+	// variable's degree only falls, so an entry whose degree
+	// is out of date is pushed again when it comes up.
+	typedef std::pair<double, uint32_t> Candidate;
+	std::priority_queue<Candidate, std::vector<Candidate>,
+		std::greater<Candidate>> heavy;
+	auto ratio = [&](uint32_t var){
+		return static_cast<double>(weights[var])
+			/ static_cast<double>(degree[var] + 1);
+	};
+	for (uint32_t var = 0; var < count; var++){
+		if (degree[var] >= numRegs){ heavy.emplace(ratio(var), var); }
+	}
+
+	std::vector<uint32_t> stack;
+	auto remove = [&](uint32_t var){
+		removed[var] = true;
+		stack.push_back(var);
+		for (uint32_t other : adjacent[var]){
+			if (removed[other]){ continue; }
+			if (degree[other]-- == numRegs){ low.push_back(other); }
+		}
+	};
+	while (stack.size() < count){
+		if (!low.empty()){
+			uint32_t var = low.back();
+			low.pop_back();
+			if (!removed[var]){ remove(var); }
+			continue;
+		}
+		Candidate next = heavy.top();
+		heavy.pop();
+		if (removed[next.second]){ continue; }
+		if (next.first != ratio(next.second)){
+			heavy.emplace(ratio(next.second), next.second);
+			continue;
+		}
+		remove(next.second);
+	}
+
+	std::vector<size_t> taken(numRegs, 0);
+	size_t stamp = 0;
+	while (!stack.empty()){
+		uint32_t var = stack.back();
+		stack.pop_back();
+		stamp++;
+		for (uint32_t other : adjacent[var]){
+			if (regs[other] != NO_REG){ taken[regs[other]] = stamp; }
+		}
+		for (uint32_t reg = 0; reg < numRegs; reg++){
+			if (taken[reg] != stamp){
+				regs[var] = reg;
+				break;
+			}
+		}
+	}
+	return costOf(regs);
+}
+
+void RegAllocator::rewrite(const std::vector<uint32_t>& regs,
+	RegAllocStats& stats){
+	std::vector<Quad>& body = proc->getBody();
+	std::vector<OpdID> regOpds(numRegs);
+	for (uint32_t reg = 0; reg < numRegs; reg++){
+		regOpds[reg] = proc->getRegOpd(reg);
+	}
+
+	//A variable's slot is clean while it holds the same value
+	// as the register. Nothing is known at the start of a
+	// block.
+	std::vector<size_t> cleanIn(vars.size(), 0);
+	size_t blockStamp = 0;
+	BlockID lastBlock = NO_BLOCK;
+	std::vector<std::pair<size_t, Quad>> inserts;
+	size_t next = 0;
+	for (size_t c = 0; c < clobberQuads.size(); c++){
+		size_t idx = clobberQuads[c];
+		BlockID block = cfg.blockOf(idx);
+		if (block != lastBlock){
+			blockStamp++;
+			lastBlock = block;
+			next = cfg.first(block);
+		}
+		//Writes since the last clobber dirty the slot
+		for (; next < idx; next++){
+			uint32_t dst = varOf(body[next].getDst());
+			if (dst != NOT_VAR){ cleanIn[dst] = 0; }
+		}
+
+		//Spill ahead of the call's SETARGs, so the argument
+		// registers aren't disturbed once they are set up
+		size_t spillAt = idx;
+		if (body[idx].getOp() == QuadOp::CALL){
+			while (spillAt > cfg.first(block)
+			  && body[spillAt - 1].getOp() == QuadOp::SETARG
+			  && body[spillAt].getLabel() == NO_LABEL){
+				spillAt--;
+			}
+		}
+		//Reload behind the GETRET, so it gets the result
+		// before anything else can touch it
+		size_t reloadAt = idx + 1;
+		if (reloadAt < cfg.end(block)
+		  && body[reloadAt].getOp() == QuadOp::GETRET){
+			reloadAt++;
+		}
+
+		std::vector<Quad> spills;
+		std::vector<Quad> reloads;
+		for (uint32_t var : across[c]){
+			if (regs[var] == NO_REG){ continue; }
+			if (cleanIn[var] != blockStamp){
+				spills.push_back(AssignQuad(vars[var], regOpds[regs[var]]));
+				cleanIn[var] = blockStamp;
+			}
+			reloads.push_back(AssignQuad(regOpds[regs[var]], vars[var]));
+		}
+		//A jump to the sequence must run the spills too
+		if (!spills.empty()){
+			spills[0].addLabel(body[spillAt].takeLabel());
+		}
+		for (const Quad& spill : spills){ inserts.emplace_back(spillAt, spill); }
+		for (const Quad& reload : reloads){
+			inserts.emplace_back(reloadAt, reload);
+		}
+		stats.spillQuads += spills.size();
+		stats.reloadQuads += reloads.size();
+	}
+
+	auto rename = [&](OpdID opd){
+		uint32_t var = varOf(opd);
+		if (var == NOT_VAR || regs[var] == NO_REG){ return opd; }
+		return regOpds[regs[var]];
+	};
+	for (Quad& quad : body){
+		quad.setDst(rename(quad.getDst()));
+		quad.setSrc1(rename(quad.getSrc1()));
+		quad.setSrc2(rename(quad.getSrc2()));
+	}
+	//Each clobber's inserts come after the last one's, so
+	// they are already in order
+	proc->insertQuads(inserts);
+	proc->dropUnusedTemps();
+}
+
+RegAllocStats RegAllocator::run(){
+	RegAllocStats stats;
+	findVariables();
+	stats.variables = vars.size();
+	stats.slotsBefore = vars.size();
+	if (vars.empty()){ return stats; }
+
+	findIntervals();
+	std::vector<uint32_t> regs;
+	size_t cost = linearScan(regs);
+	walkLiveness(cost > 0);
+	if (cost > 0){
+		std::vector<uint32_t> colors;
+		if (colorGraph(colors) < cost){
+			regs.swap(colors);
+			stats.colored = 1;
+		}
+	}
+	rewrite(regs, stats);
+
+	std::vector<bool> mentioned(vars.size(), false);
+	for (const Quad& quad : proc->getBody()){
+		for (OpdID opd : {quad.getDst(), quad.getSrc1(), quad.getSrc2()}){
+			if (varOf(opd) != NOT_VAR){ mentioned[varOf(opd)] = true; }
+		}
+	}
+	for (uint32_t var = 0; var < vars.size(); var++){
+		if (regs[var] == NO_REG){
+			stats.spilled++;
+		} else {
+			stats.inRegisters++;
+		}
+		if (mentioned[var]){ stats.slotsAfter++; }
+	}
+	return stats;
+}
+
+RegAllocStats allocateRegisters(Procedure * proc, size_t numRegs){
+	if (numRegs == 0){
+		throw new InternalError("Register allocation with no registers");
+	}
+	RegAllocator allocator(proc, numRegs);
+	return allocator.run();
+}
+
+RegAllocStats allocateRegisters(IRProgram * prog, size_t numRegs){
+	RegAllocStats stats;
+	for (Procedure * proc : *prog->getProcs()){
+		stats += allocateRegisters(proc, numRegs);
+	}
+	return stats;
+}
+
+}
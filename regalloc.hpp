@@ -0,0 +1,59 @@
+#ifndef CSHANTY_REGALLOC_HPP
+#define CSHANTY_REGALLOC_HPP
+
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//Register allocation: maps a procedure's temps, locals and
+// formals onto numRegs machine registers (operands r0 to
+// rN-1) and rewrites the body to use them. The procedure
+// must not be in SSA form, and no other pass should run on
+// it afterward.
+//
+//Each variable gets a live interval, from the first to the
+// last position (in body order) where it is live, and a
+// linear scan over the intervals hands out registers,
+// leaving the variable whose interval ends furthest away in
+// memory whenever there are more live intervals than
+// registers. Intervals over-approximate where a variable is
+// live, so when the scan has to leave anything in memory,
+// the real interference graph is colored too (Chaitin and
+// Briggs' simplify and select), and whichever leaves fewer
+// reads and writes in memory wins.
+//
+//No register keeps its value across a call (CALL, and the
+// runtime calls behind REPORT and RECEIVE). A variable in a
+// register that is live across one is spilled to its frame
+// slot before the call (ahead of its SETARGs) and reloaded
+// after it (behind its GETRET), unless the slot is known to
+// hold it already. These copies are the only quads added.
+// Variables left in memory are read and written there
+// directly.
+
+//What register allocation did
+struct RegAllocStats{
+	//Variables the body mentions, and how many of them went
+	// in registers and how many were left in memory
+	size_t variables = 0;
+	size_t inRegisters = 0;
+	size_t spilled = 0;
+	//Quads storing registers before calls and loading them
+	// back after
+	size_t spillQuads = 0;
+	size_t reloadQuads = 0;
+	//Frame slots the body needed before and after
+	size_t slotsBefore = 0;
+	size_t slotsAfter = 0;
+	//Procedures where graph coloring beat the linear scan
+	size_t colored = 0;
+
+	RegAllocStats& operator+=(const RegAllocStats& other);
+};
+
+RegAllocStats allocateRegisters(Procedure * proc, size_t numRegs);
+RegAllocStats allocateRegisters(IRProgram * prog, size_t numRegs);
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include <string>
+#include "runtime.hpp"
+#include "stdcshanty.h"
+
+namespace cshanty{
+
+//std::getline, like the runtime's, takes the whole line and
+// drops the newline
+static bool readLine(std::istream& in, std::ostream& out, std::string& line){
+	out.flush();
+	return static_cast<bool>(std::getline(in, line));
+}
+
+int64_t receiveInt(std::istream& in, std::ostream& out){
+	std::string line;
+	if (!readLine(in, out, line)){ return 0; }
+	return cshantyParseInt(line.c_str());
+}
+
+int64_t receiveBool(std::istream& in, std::ostream& out){
+	std::string line;
+	if (!readLine(in, out, line)){ return 0; }
+	return cshantyParseBool(line.c_str());
+}
+
+}
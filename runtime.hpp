@@ -0,0 +1,18 @@
+#ifndef CSHANTY_RUNTIME_HPP
+#define CSHANTY_RUNTIME_HPP
+
+#include <istream>
+#include <ostream>
+#include <stdint.h>
+
+namespace cshanty{
+
+//RECEIVE for --run and --jit: flush out, read a line from in
+// and parse it as stdcshanty.c does for -o. Both give 0 at
+// the end of the input.
+int64_t receiveInt(std::istream& in, std::ostream& out);
+int64_t receiveBool(std::istream& in, std::ostream& out);
+
+}
+
+#endif
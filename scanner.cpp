@@ -1,4 +1,5 @@
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include "scanner.hpp"
 
 using namespace cshanty;
@@ -6,15 +7,35 @@ using namespace cshanty;
 using TokenKind = cshanty::Parser::token;
 using Lexeme = cshanty::Parser::semantic_type;
 
+int Scanner::LexerInput(char * buf, int maxSize){
+	size_t left = src->size() - readPos;
+	size_t count = std::min(left, static_cast<size_t>(maxSize));
+	memcpy(buf, src->data() + readPos, count);
+	readPos += count;
+	return static_cast<int>(count);
+}
+
+size_t Scanner::scanAll(){
+	Lexeme lex;
+	size_t count = 0;
+	while (this->yylex(&lex) != TokenKind::END){
+		count++;
+	}
+	return count;
+}
+
 void Scanner::outputTokens(std::ostream& outstream){
 	Lexeme lex;
 	int tokenKind;
 	while(true){
 		tokenKind = this->yylex(&lex);
 		if (tokenKind == TokenKind::END){
+			size_t line, col;
+			srcMap->decode(static_cast<uint32_t>(charNum), 
+			  line, col);
 			outstream << "EOF" 
-			  << " [" << this->lineNum 
-			  << "," << this->colNum << "]"
+			  << " [" << line 
+			  << "," << col << "]"
 			  << std::endl;
 			return;
 		} else {
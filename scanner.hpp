@@ -7,6 +7,9 @@
 
 #include "grammar.hh"
 #include "errors.hpp"
+#include "arena.hpp"
+#include "source_file.hpp"
+#include "intern.hpp"
 
 using TokenKind = cshanty::Parser::token;
 
@@ -15,10 +18,18 @@ namespace cshanty{
 class Scanner : public yyFlexLexer{
 public:
    
-   Scanner(std::istream *in) : yyFlexLexer(in)
+   //Scans the text of srcIn. Tokens are allocated in arenaIn,
+   // and live exactly as long as that arena does; string tokens
+   // refer directly into srcIn's buffer, and identifiers are
+   // interned in namesIn. The start of each line is recorded
+   // in mapIn so that positions can be decoded later.
+   Scanner(const SourceFile * srcIn, Arena * arenaIn, 
+     SourceMap * mapIn, Interner * namesIn) 
+   : yyFlexLexer(nullptr), src(srcIn), arena(arenaIn), 
+     srcMap(mapIn), names(namesIn)
    {
-	lineNum = 1;
-	colNum = 1;
+	charNum = 0;
+	readPos = 0;
    };
    virtual ~Scanner() {
    };
@@ -30,36 +41,57 @@ public:
    virtual int yylex( cshanty::Parser::semantic_type * const lval);
 
    int makeBareToken(int tagIn){
-	size_t len = static_cast<size_t>(yyleng);
-	Position * pos = new Position(
-	  this->lineNum, this->colNum,
-	  this->lineNum, this->colNum+len);
-        this->yylval->lexeme = new Token(pos, tagIn);
-        colNum += len;
+	Position pos = matchPos();
+        this->yylval->lexeme = arena->make<Token>(pos, tagIn);
+        charNum += static_cast<size_t>(yyleng);
         return tagIn;
    }
 
-   void errIllegal(Position * pos, std::string match){
+   //The span of the text matched by the current rule
+   Position matchPos(){
+	size_t len = static_cast<size_t>(yyleng);
+	return Position(static_cast<uint32_t>(charNum),
+	  static_cast<uint32_t>(charNum + len));
+   }
+
+   //The text matched by the current rule, as a view into
+   // the source buffer
+   TextView matchText(){
+	return src->view(charNum, static_cast<size_t>(yyleng));
+   }
+
+   //The text matched by the current rule, interned
+   Ident matchIdent(){
+	return names->intern(src->data() + charNum, 
+	  static_cast<size_t>(yyleng));
+   }
+
+   void newLine(){
+	charNum += static_cast<size_t>(yyleng);
+	srcMap->addLine(static_cast<uint32_t>(charNum));
+   }
+
+   void errIllegal(Position pos, std::string match){
 	cshanty::Report::fatal(pos, "Illegal character "
 		+ match);
    }
 
-   void errStrEsc(Position * pos){
+   void errStrEsc(Position pos){
 	cshanty::Report::fatal(pos, "String literal with bad"
 	" escape sequence ignored");
    }
 
-   void errStrUnterm(Position * pos){
+   void errStrUnterm(Position pos){
 	cshanty::Report::fatal(pos, "Unterminated string"
 	" literal ignored");
    }
 
-   void errStrEscAndUnterm(Position * pos){
+   void errStrEscAndUnterm(Position pos){
 	cshanty::Report::fatal(pos, "Unterminated string literal"
 	" with bad escape sequence ignored");
    }
 
-   void errIntOverflow(Position * pos){
+   void errIntOverflow(Position pos){
 	cshanty::Report::fatal(pos, "Integer literal too large;"
 	" using max value");
    }
@@ -79,11 +111,23 @@ public:
    static std::string tokenKindString(int tokenKind);
 
    void outputTokens(std::ostream& outstream);
+   //Scan to the end of the input, returning the number of
+   // tokens (not counting the end of file)
+   size_t scanAll();
+
+protected:
+   //Feed flex straight from the source buffer rather than
+   // through an istream
+   virtual int LexerInput(char * buf, int maxSize) override;
 
 private:
    cshanty::Parser::semantic_type *yylval = nullptr;
-   size_t lineNum;
-   size_t colNum;
+   const SourceFile * src;
+   size_t readPos;
+   Arena * arena;
+   SourceMap * srcMap;
+   Interner * names;
+   size_t charNum;
 };
 
 } /* end namespace */
@@ -0,0 +1,57 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "source_file.hpp"
+
+namespace cshanty{
+
+SourceFile::SourceFile()
+: myData(""), mySize(0), mapped(false){
+}
+
+SourceFile::~SourceFile(){
+	if (mapped){
+		munmap(const_cast<char *>(myData), mySize);
+	}
+}
+
+bool SourceFile::open(const char * path){
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0){ return false; }
+
+	struct stat info;
+	bool ok = false;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+		size_t len = static_cast<size_t>(info.st_size);
+		void * addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED){
+			//The scanner reads front to back exactly once
+			madvise(addr, len, MADV_SEQUENTIAL);
+			myData = static_cast<const char *>(addr);
+			mySize = len;
+			mapped = true;
+			ok = true;
+		}
+	}
+	if (!ok){
+		ok = readAll(fd);
+	}
+	close(fd);
+	return ok;
+}
+
+bool SourceFile::readAll(int fd){
+	char chunk[64 * 1024];
+	while (true){
+		ssize_t got = read(fd, chunk, sizeof(chunk));
+		if (got < 0){ return false; }
+		if (got == 0){ break; }
+		owned.insert(owned.end(), chunk, chunk + got);
+	}
+	myData = owned.empty() ? "" : owned.data();
+	mySize = owned.size();
+	return true;
+}
+
+}
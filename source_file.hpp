@@ -0,0 +1,63 @@
+#ifndef CSHANTY_SOURCE_FILE_HPP
+#define CSHANTY_SOURCE_FILE_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cshanty{
+
+//A non-owning reference to a run of characters, usually
+// a lexeme inside a SourceFile's buffer. The referenced
+// text must outlive the view.
+class TextView{
+public:
+	TextView() : myData(nullptr), myLen(0){ }
+	TextView(const char * dataIn, size_t lenIn)
+	: myData(dataIn), myLen(lenIn){ }
+	const char * data() const { return myData; }
+	size_t length() const { return myLen; }
+	std::string str() const { return std::string(myData, myLen); }
+private:
+	const char * myData;
+	size_t myLen;
+};
+
+inline std::ostream& operator<<(std::ostream& out, TextView view){
+	return out.write(view.data(), static_cast<std::streamsize>(view.length()));
+}
+
+//The complete text of one input file, held in a single
+// contiguous buffer for the whole compilation. Regular
+// files are mapped into memory; anything that can't be
+// mapped (pipes, for example) is read into an owned buffer
+// instead. Either way, tokens can refer directly to the
+// text they were scanned from.
+class SourceFile{
+public:
+	SourceFile();
+	~SourceFile();
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	//Returns false if the file couldn't be read at all
+	bool open(const char * path);
+
+	const char * data() const { return myData; }
+	size_t size() const { return mySize; }
+	bool isMapped() const { return mapped; }
+	TextView view(size_t offset, size_t len) const{
+		return TextView(myData + offset, len);
+	}
+private:
+	bool readAll(int fd);
+
+	const char * myData;
+	size_t mySize;
+	bool mapped;
+	std::vector<char> owned;
+};
+
+}
+
+#endif
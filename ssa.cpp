@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <unordered_map>
+#include "cfg.hpp"
+#include "liveness.hpp"
+#include "ssa.hpp"
+
+namespace cshanty{
+
+//Whether a quad reads src1 as a value (CALL names its callee
+// and INDEX its base by location instead)
+static bool readsSrc1(const Quad& quad){
+	return quad.getOp() != QuadOp::CALL && quad.getOp() != QuadOp::INDEX;
+}
+
+//The dominance frontier of each reachable block: the joins
+// it reaches without dominating (Cooper, Harvey and Kennedy's
+// method, walking up the dominator tree from each
+// predecessor of a join)
+static std::vector<std::vector<BlockID>> findFrontiers(const CFG& cfg){
+	std::vector<std::vector<BlockID>> frontiers(cfg.numBlocks());
+	for (BlockID block : cfg.rpo()){
+		if (cfg.preds(block).size() < 2){ continue; }
+		for (BlockID pred : cfg.preds(block)){
+			if (!cfg.reachable(pred)){ continue; }
+			BlockID runner = pred;
+			while (runner != cfg.idom(block)){
+				//Everything above was covered by an earlier walk
+				if (!frontiers[runner].empty()
+				  && frontiers[runner].back() == block){
+					break;
+				}
+				frontiers[runner].push_back(block);
+				runner = cfg.idom(runner);
+			}
+		}
+	}
+	return frontiers;
+}
+
+//Put PHI quads (with arguments still unset) at the start of
+// each block that needs them, returning the variable each
+// phi is for, by phi number
+static std::vector<OpdID> placePhis(Procedure * proc){
+	CFG cfg(proc);
+	cfg.computeDominators();
+	Liveness live(cfg);
+	std::vector<std::vector<BlockID>> frontiers = findFrontiers(cfg);
+	std::vector<Quad>& body = proc->getBody();
+	size_t blocks = cfg.numBlocks();
+
+	//Only variables read outside the block writing them can
+	// need phis, and those are exactly the liveness slots
+	std::vector<std::vector<BlockID>> defBlocks(live.numSlots());
+	for (BlockID block : cfg.rpo()){
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			uint32_t slot = live.slotOf(body[i].getDst());
+			if (slot == Liveness::NO_SLOT){ continue; }
+			std::vector<BlockID>& defs = defBlocks[slot];
+			if (defs.empty() || defs.back() != block){ defs.push_back(block); }
+		}
+	}
+
+	//Spread each variable's writes over the iterated
+	// frontier, only stopping where the variable is live
+	std::vector<std::vector<OpdID>> blockPhis(blocks);
+	std::vector<uint32_t> hasPhi(blocks, Liveness::NO_SLOT);
+	std::vector<uint32_t> queued(blocks, Liveness::NO_SLOT);
+	std::vector<BlockID> worklist;
+	for (uint32_t slot = 0; slot < live.numSlots(); slot++){
+		worklist = defBlocks[slot];
+		for (BlockID block : worklist){ queued[block] = slot; }
+		while (!worklist.empty()){
+			BlockID block = worklist.back();
+			worklist.pop_back();
+			for (BlockID join : frontiers[block]){
+				if (hasPhi[join] == slot || !live.liveIn(join).test(slot)){
+					continue;
+				}
+				hasPhi[join] = slot;
+				blockPhis[join].push_back(live.opdOfSlot(slot));
+				if (queued[join] != slot){
+					queued[join] = slot;
+					worklist.push_back(join);
+				}
+			}
+		}
+	}
+
+	//The phis take over the label of the block's first quad,
+	// so jumps into the block land on them
+	std::vector<OpdID> phiVars;
+	std::vector<std::pair<size_t, Quad>> inserts;
+	for (BlockID block = 0; block < blocks; block++){
+		if (blockPhis[block].empty()){ continue; }
+		size_t at = cfg.first(block);
+		LabelID label = body[at].takeLabel();
+		size_t numPreds = cfg.preds(block).size();
+		for (OpdID var : blockPhis[block]){
+			PhiQuad phi(var, proc->makePhi(numPreds));
+			phi.addLabel(label);
+			label = NO_LABEL;
+			inserts.push_back(std::make_pair(at, phi));
+			phiVars.push_back(var);
+		}
+	}
+	proc->insertQuads(inserts);
+	return phiVars;
+}
+
+size_t toSSA(Procedure * proc){
+	//Control enters the entry block from outside, so it must
+	// not be a join; a loop back to the first quad gets an
+	// empty block in front of it
+	{
+		CFG cfg(proc);
+		if (!cfg.preds(cfg.entry()).empty()){
+			proc->insertQuads({std::make_pair(size_t(0), Quad(NopQuad()))});
+		}
+	}
+	std::vector<bool> variable(proc->numOpds(), false);
+	for (const std::vector<OpdID> * vars :
+	  {&proc->getFormals(), &proc->getLocals(), &proc->getTemps()}){
+		for (OpdID var : *vars){ variable[var] = true; }
+	}
+	std::vector<OpdID> phiVars = placePhis(proc);
+
+	//Placing phis keeps the blocks as they were, but moves
+	// their quads
+	CFG cfg(proc);
+	cfg.computeDominators();
+	std::vector<Quad>& body = proc->getBody();
+
+	//Walk the dominator tree, renaming as we go. current
+	// holds each variable's version at this point of the
+	// walk (initially the variable itself, for whatever it
+	// held on entry); each change is logged, so leaving a
+	// block can undo the changes made in it.
+	std::vector<OpdID> current(variable.size());
+	for (OpdID opd = 0; opd < current.size(); opd++){ current[opd] = opd; }
+	std::vector<uint32_t> numVersions(variable.size(), 0);
+	std::vector<std::pair<OpdID, OpdID>> undo;
+	auto isVar = [&](OpdID opd){
+		return opd < variable.size() && variable[opd];
+	};
+	auto define = [&](OpdID var){
+		OpdID version = proc->makeVersion(var, ++numVersions[var]);
+		undo.push_back(std::make_pair(var, current[var]));
+		current[var] = version;
+		return version;
+	};
+
+	struct Visit{
+		BlockID block;
+		//On the way out: how far to rewind undo
+		size_t mark;
+		bool leaving;
+	};
+	std::vector<Visit> stack;
+	stack.push_back({cfg.entry(), 0, false});
+	while (!stack.empty()){
+		Visit visit = stack.back();
+		stack.pop_back();
+		if (visit.leaving){
+			while (undo.size() > visit.mark){
+				current[undo.back().first] = undo.back().second;
+				undo.pop_back();
+			}
+			continue;
+		}
+		BlockID block = visit.block;
+		stack.push_back({block, undo.size(), true});
+
+		for (size_t i = cfg.first(block); i < cfg.end(block); i++){
+			Quad& quad = body[i];
+			if (quad.getOp() == QuadOp::PHI){
+				quad.setDst(define(phiVars[quad.getIndex()]));
+				continue;
+			}
+			//A copy between variables makes no version: its
+			// destination just takes the source's, so later
+			// reads and phis see through it (copy folding)
+			if (quad.getOp() == QuadOp::ASSIGN && isVar(quad.getDst())
+			  && isVar(quad.getSrc())){
+				undo.push_back(std::make_pair(quad.getDst(), current[quad.getDst()]));
+				current[quad.getDst()] = current[quad.getSrc()];
+				proc->replaceQuad(i, NopQuad());
+				continue;
+			}
+			if (readsSrc1(quad) && isVar(quad.getSrc1())){
+				quad.setSrc1(current[quad.getSrc1()]);
+			}
+			if (isVar(quad.getSrc2())){
+				quad.setSrc2(current[quad.getSrc2()]);
+			}
+			if (isVar(quad.getDst())){
+				quad.setDst(define(quad.getDst()));
+			}
+		}
+
+		//Fill in this block's column of its successors' phis
+		for (BlockID succ : cfg.succs(block)){
+			BlockRange preds = cfg.preds(succ);
+			size_t column = static_cast<size_t>(
+				std::find(preds.begin(), preds.end(), block) - preds.begin());
+			for (size_t i = cfg.first(succ); i < cfg.end(succ)
+			  && body[i].getOp() == QuadOp::PHI; i++){
+				uint32_t phi = static_cast<uint32_t>(body[i].getIndex());
+				proc->getPhiArgs(phi)[column] = current[phiVars[phi]];
+			}
+		}
+
+		for (BlockID child : cfg.domChildren(block)){
+			stack.push_back({child, 0, false});
+		}
+	}
+	return phiVars.size();
+}
+
+//Sequence a parallel copy (each dst gets its src's value as
+// it was before any of the copies) into plain copies,
+// appending them to out. A copy is ready once no pending
+// copy still reads its dst; when only cycles are left, one
+// dst is saved in a new temp to break its cycle.
+static void sequenceCopies(Procedure * proc,
+	const std::vector<std::pair<OpdID, OpdID>>& moves,
+	std::vector<Quad>& out){
+	if (moves.size() == 1){
+		out.push_back(AssignQuad(moves[0].first, moves[0].second));
+		return;
+	}
+	//Where each source's original value can now be read
+	std::unordered_map<OpdID, OpdID> locs;
+	std::unordered_map<OpdID, uint32_t> readers;
+	std::unordered_map<OpdID, size_t> writers;
+	for (size_t i = 0; i < moves.size(); i++){
+		readers[moves[i].second]++;
+		writers[moves[i].first] = i;
+	}
+	auto locOf = [&](OpdID opd){
+		auto found = locs.find(opd);
+		return found == locs.end() ? opd : found->second;
+	};
+
+	std::vector<bool> done(moves.size(), false);
+	std::vector<size_t> ready;
+	for (size_t i = 0; i < moves.size(); i++){
+		if (readers.count(moves[i].first) == 0){ ready.push_back(i); }
+	}
+	size_t next = 0;
+	while (true){
+		while (!ready.empty()){
+			size_t i = ready.back();
+			ready.pop_back();
+			OpdID src = moves[i].second;
+			out.push_back(AssignQuad(moves[i].first, locOf(src)));
+			done[i] = true;
+			uint32_t& count = readers[src];
+			if (count > 0 && --count == 0){
+				auto writer = writers.find(src);
+				if (writer != writers.end() && !done[writer->second]){
+					ready.push_back(writer->second);
+				}
+			}
+		}
+		while (next < moves.size() && done[next]){ next++; }
+		if (next == moves.size()){ return; }
+
+		OpdID dst = moves[next].first;
+		OpdID saved = proc->makeTmp(proc->getOpd(dst).getWidth());
+		out.push_back(AssignQuad(saved, dst));
+		locs[dst] = saved;
+		readers[dst] = 0;
+		ready.push_back(next);
+	}
+}
+
+size_t fromSSA(Procedure * proc){
+	CFG cfg(proc);
+	std::vector<Quad>& body = proc->getBody();
+	size_t bodySize = body.size();
+	std::vector<bool> isPhi(bodySize, false);
+	std::vector<std::pair<size_t, Quad>> inserts;
+	//Blocks splitting edges from an IFZ to its target,
+	// placed after the end of the body
+	std::vector<Quad> splits;
+	size_t copies = 0;
+
+	for (BlockID block = 0; block < cfg.numBlocks(); block++){
+		size_t first = cfg.first(block);
+		size_t stop = first;
+		while (stop < cfg.end(block) && body[stop].getOp() == QuadOp::PHI){
+			isPhi[stop++] = true;
+		}
+		if (stop == first){ continue; }
+
+		BlockRange preds = cfg.preds(block);
+		for (size_t column = 0; column < preds.size(); column++){
+			std::vector<std::pair<OpdID, OpdID>> moves;
+			for (size_t i = first; i < stop; i++){
+				uint32_t phi = static_cast<uint32_t>(body[i].getIndex());
+				OpdID src = proc->getPhiArgs(phi)[column];
+				if (src != NO_OPD && src != body[i].getDst()){
+					moves.push_back(std::make_pair(body[i].getDst(), src));
+				}
+			}
+			if (moves.empty()){ continue; }
+			std::vector<Quad> seq;
+			sequenceCopies(proc, moves, seq);
+			copies += seq.size();
+
+			size_t last = cfg.end(preds[column]) - 1;
+			Quad& tail = body[last];
+			if (tail.getOp() == QuadOp::GOTO){
+				//Anything jumping to the goto must run the copies
+				seq.front().addLabel(tail.takeLabel());
+				for (const Quad& copy : seq){
+					inserts.push_back(std::make_pair(last, copy));
+				}
+				continue;
+			}
+			if (tail.getOp() != QuadOp::IFZ
+			  || (last + 1 < bodySize && cfg.blockOf(last + 1) == block)){
+				//Falling through: the copies go before the
+				// block's label, which only jumps skip
+				for (const Quad& copy : seq){
+					inserts.push_back(std::make_pair(last + 1, copy));
+				}
+			}
+			if (tail.getOp() == QuadOp::IFZ
+			  && cfg.blockOfLabel(tail.getTarget()) == block){
+				LabelID split = proc->makeLabel();
+				seq.front().addLabel(split);
+				splits.insert(splits.end(), seq.begin(), seq.end());
+				splits.push_back(GotoQuad(tail.getTarget()));
+				proc->replaceQuad(last, IfzQuad(tail.getSrc(), split));
+			}
+		}
+	}
+
+	std::stable_sort(inserts.begin(), inserts.end(),
+		[](const std::pair<size_t, Quad>& a, const std::pair<size_t, Quad>& b){
+			return a.first < b.first;
+		});
+	if (!splits.empty()){
+		//Keep the end of the body from running into them
+		if (bodySize == 0 || body.back().getOp() != QuadOp::GOTO){
+			splits.insert(splits.begin(), GotoQuad(proc->getLeaveLabel()));
+		}
+		for (const Quad& quad : splits){
+			inserts.push_back(std::make_pair(bodySize, quad));
+		}
+	}
+	proc->insertQuads(inserts);
+
+	//Drop the phis, wherever the insertions moved them
+	std::vector<bool> dead(body.size(), false);
+	size_t shift = 0;
+	for (size_t i = 0; i < bodySize; i++){
+		while (shift < inserts.size() && inserts[shift].first <= i){ shift++; }
+		if (isPhi[i]){ dead[i + shift] = true; }
+	}
+	proc->removeQuads(dead);
+	proc->clearPhis();
+	proc->dropUnusedTemps();
+	return copies;
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef CSHANTY_SSA_HPP
+#define CSHANTY_SSA_HPP
+
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//Static single assignment form. In SSA form every write to
+// a temp, local or formal makes a new version of it (x.1,
+// x.2, ...), each written by exactly one quad, and where
+// different versions of a variable meet at a join in the
+// control-flow graph a PHI quad at the start of the block
+// picks the one for the edge control came in on. Globals
+// and address temps are memory and keep their one name.
+//
+//The phi arguments of a block follow the order of its
+// predecessors in the CFG (see cfg.hpp), so a pass working
+// on SSA form must not add or remove edges without fixing
+// them up. The other analyses and passes (liveness and the
+// passes in opt.hpp) only understand procedures outside
+// SSA form.
+
+//Put proc into SSA form: phis are placed on the iterated
+// dominance frontiers of each variable's writes, wherever
+// the variable is live, and then every write and read is
+// renamed by a walk over the dominator tree. Copies from one
+// variable to another are folded away as they are renamed,
+// so phis may end up swapping versions around a loop.
+// Variables only read in the block that writes them get no
+// phis. Returns the number of phis placed.
+size_t toSSA(Procedure * proc);
+
+//Take proc out of SSA form: each phi becomes a parallel copy
+// at the end of every predecessor, sequenced so no copy
+// overwrites a value another still needs (with a temp to
+// break cycles). Edges from a block that branches two ways
+// into a join are split first. The versions stay on as
+// temps. Returns the number of copies inserted.
+size_t fromSSA(Procedure * proc);
+
+}
+
+#endif
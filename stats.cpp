@@ -0,0 +1,123 @@
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include "stats.hpp"
+
+//The allocations of the current thread. They are plain
+// zero-initialized thread locals, so counting needs no
+// set-up and works from the first allocation on.
+static thread_local size_t allocCount = 0;
+static thread_local size_t allocBytes = 0;
+
+void * operator new(size_t size){
+	allocCount++;
+	allocBytes += size;
+	void * mem = malloc(size == 0 ? 1 : size);
+	if (mem == nullptr){ throw std::bad_alloc(); }
+	return mem;
+}
+
+void * operator new[](size_t size){
+	return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t&) noexcept{
+	allocCount++;
+	allocBytes += size;
+	return malloc(size == 0 ? 1 : size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t& tag) noexcept{
+	return operator new(size, tag);
+}
+
+void operator delete(void * mem) noexcept{ free(mem); }
+void operator delete[](void * mem) noexcept{ free(mem); }
+void operator delete(void * mem, size_t) noexcept{ free(mem); }
+void operator delete[](void * mem, size_t) noexcept{ free(mem); }
+void operator delete(void * mem, const std::nothrow_t&) noexcept{ free(mem); }
+void operator delete[](void * mem, const std::nothrow_t&) noexcept{ free(mem); }
+
+namespace cshanty{
+
+AllocCounts allocationsSoFar(){
+	AllocCounts res;
+	res.count = allocCount;
+	res.bytes = allocBytes;
+	return res;
+}
+
+void PhaseStats::begin(const char * name){
+	if (!enabled){ return; }
+	end();
+	Phase phase;
+	phase.name = name;
+	phase.ms = 0;
+	phases.push_back(phase);
+	inPhase = true;
+	startAllocs = allocationsSoFar();
+	started = Clock::now();
+}
+
+void PhaseStats::end(){
+	if (!enabled || !inPhase){ return; }
+	Clock::time_point stopped = Clock::now();
+	AllocCounts now = allocationsSoFar();
+	Phase& phase = phases.back();
+	phase.ms = std::chrono::duration<double, std::milli>(stopped - started).count();
+	phase.allocs.count = now.count - startAllocs.count;
+	phase.allocs.bytes = now.bytes - startAllocs.bytes;
+	inPhase = false;
+}
+
+void PhaseStats::count(const char * name, size_t val){
+	if (!enabled){ return; }
+	counts.emplace_back(name, val);
+}
+
+//Write str as a JSON string
+static void writeString(std::ostream& out, const std::string& str){
+	out << '"';
+	for (char c : str){
+		if (c == '"' || c == '\\'){
+			out << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20){
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			out << buf;
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+void PhaseStats::writeJSON(std::ostream& out, const std::string& file) const{
+	double totalMs = 0;
+	AllocCounts total;
+	out << "{\n  \"file\": ";
+	writeString(out, file);
+	out << ",\n  \"phases\": [";
+	for (size_t i = 0; i < phases.size(); i++){
+		const Phase& phase = phases[i];
+		out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+		writeString(out, phase.name);
+		out << ", \"wall_ms\": " << phase.ms
+			<< ", \"allocs\": " << phase.allocs.count
+			<< ", \"alloc_bytes\": " << phase.allocs.bytes << "}";
+		totalMs += phase.ms;
+		total.count += phase.allocs.count;
+		total.bytes += phase.allocs.bytes;
+	}
+	out << "\n  ],\n  \"total\": {\"wall_ms\": " << totalMs
+		<< ", \"allocs\": " << total.count
+		<< ", \"alloc_bytes\": " << total.bytes << "},\n  \"counts\": {";
+	for (size_t i = 0; i < counts.size(); i++){
+		out << (i == 0 ? "\n    " : ",\n    ");
+		writeString(out, counts[i].first);
+		out << ": " << counts[i].second;
+	}
+	out << "\n  }\n}\n";
+}
+
+}
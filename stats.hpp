@@ -0,0 +1,60 @@
+#ifndef CSHANTY_STATS_HPP
+#define CSHANTY_STATS_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cshanty{
+
+//Heap allocations (through operator new) made so far by
+// the calling thread. stats.cpp replaces the global
+// operator new to count them; the count is per thread so
+// compilations running side by side in batch mode each see
+// only their own. Arena storage is counted when the arena
+// takes a block, not per object.
+struct AllocCounts{
+	size_t count = 0;
+	size_t bytes = 0;
+};
+AllocCounts allocationsSoFar();
+
+//What --stats reports about one compilation: the wall time
+// and heap allocations of each phase, and counts of what the
+// phases built. Phases are timed one after another; a
+// disabled PhaseStats ignores everything, so the compiler
+// can call it unconditionally.
+class PhaseStats{
+public:
+	explicit PhaseStats(bool enabledIn) : enabled(enabledIn), inPhase(false){ }
+
+	//Start timing a phase, ending the one before if need be
+	void begin(const char * name);
+	void end();
+	void count(const char * name, size_t val);
+	bool isEnabled() const { return enabled; }
+
+	//Write everything as one JSON object, for the compilation
+	// of file
+	void writeJSON(std::ostream& out, const std::string& file) const;
+private:
+	typedef std::chrono::steady_clock Clock;
+	struct Phase{
+		std::string name;
+		double ms;
+		AllocCounts allocs;
+	};
+
+	bool enabled;
+	bool inPhase;
+	std::vector<Phase> phases;
+	std::vector<std::pair<std::string, size_t>> counts;
+	Clock::time_point started;
+	AllocCounts startAllocs;
+};
+
+}
+
+#endif
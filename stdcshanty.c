@@ -0,0 +1,58 @@
+/* The runtime for programs compiled with cshantyc -o. The
+ * generated assembly calls these for report and receive;
+ * link them in with, e.g.:
+ *   cshantyc prog.cshanty -o prog.s
+ *   cc -o prog prog.s stdcshanty.o
+ * Every value is passed as a 64-bit integer (or a pointer,
+ * for strings), following the System V calling convention.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stdcshanty.h"
+
+void printInt(long num){
+	printf("%ld", num);
+}
+
+void printBool(long b){
+	fputs(b ? "true" : "false", stdout);
+}
+
+void printString(const char * str){
+	fputs(str, stdout);
+}
+
+/* Input is read a whole line at a time, however long, and
+ * the newline dropped. Anything printed so far is flushed
+ * first, so prompts appear before the program waits.
+ * Returns NULL at the end of the input. */
+static const char * readLine(void){
+	static char * line = NULL;
+	static size_t cap = 0;
+	ssize_t len;
+	fflush(stdout);
+	len = getline(&line, &cap, stdin);
+	if (len < 0){ return NULL; }
+	if (len > 0 && line[len - 1] == '\n'){ line[len - 1] = '\0'; }
+	return line;
+}
+
+long cshantyParseInt(const char * line){
+	return strtol(line, NULL, 10);
+}
+
+long cshantyParseBool(const char * line){
+	return !(line[0] == '\0' || line[0] == '0' || line[0] == 'f');
+}
+
+long getInt(void){
+	const char * line = readLine();
+	return line == NULL ? 0 : cshantyParseInt(line);
+}
+
+long getBool(void){
+	const char * line = readLine();
+	return line == NULL ? 0 : cshantyParseBool(line);
+}
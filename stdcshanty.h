@@ -0,0 +1,27 @@
+/* The runtime for programs compiled with cshantyc -o (see
+ * stdcshanty.c). The compiler links it in too, so --run and
+ * --jit parse input with the same functions. */
+#ifndef CSHANTY_STDCSHANTY_H
+#define CSHANTY_STDCSHANTY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void printInt(long num);
+void printBool(long b);
+void printString(const char * str);
+long getInt(void);
+long getBool(void);
+
+/* The value of a line of input, without its newline. An int
+ * is read as strtol reads it; false, 0 and an empty line are
+ * false, and anything else is true. */
+long cshantyParseInt(const char * line);
+long cshantyParseBool(const char * line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
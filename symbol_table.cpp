@@ -2,88 +2,160 @@
 #include "types.hpp"
 namespace cshanty{
 
-SymbolTable::SymbolTable(){
-	scopeTableChain = new std::list<ScopeTable *>();
+const uint32_t SymbolTable::NONE;
+
+SymbolTable::SymbolTable()
+: slots(64, Slot{0, NONE}), slotsUsed(0), declared(0){
 }
 
 void SymbolTable::print(){
-	for(auto scope : *scopeTableChain){
+	size_t end = undoLog.size();
+	for (size_t d = marks.size(); d > 0; d--){
 		std::cout << "--- scope ---\n";
-		std::cout << scope->toString();
+		for (size_t i = marks[d - 1]; i < end; i++){
+			std::cout << bindings[undoLog[i]].sym->toString();
+			std::cout << "\n";
+		}
+		end = marks[d - 1];
 	}
 }
 
-ScopeTable * SymbolTable::enterScope(){
-	ScopeTable * newScope = new ScopeTable();
-	scopeTableChain->push_front(newScope);
-	return newScope;
+void SymbolTable::enterScope(){
+	marks.push_back(undoLog.size());
 }
 
 void SymbolTable::leaveScope(){
-	if (scopeTableChain->empty()){
+	if (marks.empty()){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
-	scopeTableChain->pop_front();
+	size_t mark = marks.back();
+	marks.pop_back();
+	while (undoLog.size() > mark){
+		uint32_t idx = undoLog.back();
+		undoLog.pop_back();
+		const Binding& b = bindings[idx];
+		slots[b.slot].head = b.shadowed;
+		freeBindings.push_back(idx);
+	}
 }
 
-ScopeTable * SymbolTable::getCurrentScope(){
-	return scopeTableChain->front();
+uint32_t SymbolTable::slotFor(Ident name){
+	uint32_t key = name.id() + 1;
+	size_t mask = slots.size() - 1;
+	//Fibonacci hashing spreads the dense ids across the table
+	size_t idx = (key * 2654435769u) & mask;
+	while (slots[idx].key != key){
+		if (slots[idx].key == 0){
+			slots[idx].key = key;
+			slotsUsed++;
+			if (slotsUsed * 2 > slots.size()){
+				grow();
+				return slotFor(name);
+			}
+			break;
+		}
+		idx = (idx + 1) & mask;
+	}
+	return static_cast<uint32_t>(idx);
 }
 
-bool SymbolTable::clash(std::string varName){
-	bool hasClash = getCurrentScope()->clash(varName);
-	return hasClash;
+void SymbolTable::grow(){
+	std::vector<Slot> bigger(slots.size() * 2, Slot{0, NONE});
+	size_t mask = bigger.size() - 1;
+	std::vector<uint32_t> moved(slots.size(), NONE);
+	for (size_t i = 0; i < slots.size(); i++){
+		if (slots[i].key == 0){ continue; }
+		size_t idx = (slots[i].key * 2654435769u) & mask;
+		while (bigger[idx].key != 0){ idx = (idx + 1) & mask; }
+		bigger[idx] = slots[i];
+		moved[i] = static_cast<uint32_t>(idx);
+	}
+	for (uint32_t idx : undoLog){
+		bindings[idx].slot = moved[bindings[idx].slot];
+	}
+	slots.swap(bigger);
 }
 
-SemSymbol * SymbolTable::find(std::string varName){
-	for (ScopeTable * scope : *scopeTableChain){
-		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
+uint32_t SymbolTable::newBinding(SemSymbol * sym, size_t scopeDepth){
+	Binding b{sym, static_cast<uint32_t>(scopeDepth), NONE, 0};
+	declared++;
+	if (freeBindings.empty()){
+		bindings.push_back(b);
+		return static_cast<uint32_t>(bindings.size() - 1);
+	}
+	uint32_t idx = freeBindings.back();
+	freeBindings.pop_back();
+	bindings[idx] = b;
+	return idx;
+}
+
+SemSymbol * SymbolTable::findAtDepth(Ident name, size_t scopeDepth){
+	uint32_t cur = slots[slotFor(name)].head;
+	while (cur != NONE && bindings[cur].depth > scopeDepth){
+		cur = bindings[cur].shadowed;
+	}
+	if (cur != NONE && bindings[cur].depth == scopeDepth){
+		return bindings[cur].sym;
 	}
 	return nullptr;
 }
 
-bool SymbolTable::insert(SemSymbol * symbol){
-	return scopeTableChain->front()->insert(symbol);
+bool SymbolTable::clash(Ident varName){
+	return findAtDepth(varName, marks.size()) != nullptr;
 }
 
-ScopeTable::ScopeTable(){
-	symbols = new HashMap<std::string, SemSymbol *>();
+bool SymbolTable::clashEnclosing(Ident varName){
+	return findAtDepth(varName, marks.size() - 1) != nullptr;
 }
 
-std::string ScopeTable::toString(){
-	std::string result = "";
-	for (auto entry : *symbols){
-		result += entry.second->toString();
-		result += "\n";
-	}
-	return result;
+SemSymbol * SymbolTable::find(Ident varName){
+	uint32_t head = slots[slotFor(varName)].head;
+	if (head == NONE){ return nullptr; }
+	return bindings[head].sym;
 }
 
-bool ScopeTable::clash(std::string varName){
-	SemSymbol * found = lookup(varName);
-	if (found != nullptr){
-		return true;
+bool SymbolTable::insert(SemSymbol * symbol){
+	if (marks.empty()){
+		throw new InternalError("Insert with no open scope");
 	}
-	return false;
+	Ident name = symbol->getIdent();
+	if (clash(name)){ return false; }
+
+	uint32_t slot = slotFor(name);
+	uint32_t idx = newBinding(symbol, marks.size());
+	bindings[idx].slot = slot;
+	bindings[idx].shadowed = slots[slot].head;
+	slots[slot].head = idx;
+	undoLog.push_back(idx);
+	return true;
 }
 
-SemSymbol * ScopeTable::lookup(std::string name){
-	auto found = symbols->find(name);
-	if (found == symbols->end()){
-		return NULL;
+bool SymbolTable::insertEnclosing(SemSymbol * symbol){
+	if (marks.size() < 2){
+		throw new InternalError("Insert with no enclosing scope");
 	}
-	return found->second;
-}
+	Ident name = symbol->getIdent();
+	size_t outer = marks.size() - 1;
+	if (clashEnclosing(name)){ return false; }
 
-bool ScopeTable::insert(SemSymbol * symbol){
-	std::string symName = symbol->getName();
-	bool alreadyInScope = (this->lookup(symName) != NULL);
-	if (alreadyInScope){
-		return false;
+	//Thread the binding in beneath any that the current
+	// scope already has for the same name
+	uint32_t slot = slotFor(name);
+	uint32_t idx = newBinding(symbol, outer);
+	uint32_t * link = &slots[slot].head;
+	while (*link != NONE && bindings[*link].depth > outer){
+		link = &bindings[*link].shadowed;
 	}
-	this->symbols->insert(std::make_pair(symName, symbol));
+	bindings[idx].slot = slot;
+	bindings[idx].shadowed = *link;
+	*link = idx;
+
+	//The enclosing scope's run of the log ends where the
+	// current scope's begins
+	size_t & mark = marks.back();
+	undoLog.insert(undoLog.begin() + static_cast<std::ptrdiff_t>(mark), idx);
+	mark++;
 	return true;
 }
 
@@ -3,7 +3,10 @@
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <stdint.h>
+#include <vector>
 #include "types.hpp"
+#include "intern.hpp"
 
 //Use an alias template so that we can use
 // "HashMap" and it means "std::unordered_map"
@@ -26,10 +29,11 @@ enum SymbolKind {
 // symbol table. 
 class SemSymbol {
 public:
-	SemSymbol(std::string nameIn, const DataType * typeIn) 
+	SemSymbol(Ident nameIn, const DataType * typeIn) 
 	: myName(nameIn), myType(typeIn){ }
 	virtual std::string toString();
-	std::string getName() const { return myName; }
+	const std::string& getName() const { return myName.str(); }
+	Ident getIdent() const { return myName; }
 	virtual SymbolKind getKind() const = 0;
 
 	virtual const DataType * getDataType() const{
@@ -44,20 +48,20 @@ public:
 		return "UNKNOWN KIND";
 	} 
 private:
-	std::string myName;
+	Ident myName;
 	const DataType * myType;
 };
 
 class VarSymbol : public SemSymbol {
 public:
-	VarSymbol(std::string name, const DataType * type) 
+	VarSymbol(Ident name, const DataType * type) 
 	: SemSymbol(name, type) { }
 	virtual SymbolKind getKind() const override { return VAR; } 
 };
 
 class FnSymbol : public SemSymbol{
 public:
-	FnSymbol(std::string name, const FnType * fnType)
+	FnSymbol(Ident name, const FnType * fnType)
 	: SemSymbol(name, fnType){ }
 	virtual SymbolKind getKind() const { return FN; }
 	SymbolKind getKind(){ return FN; } 
@@ -65,53 +69,72 @@ public:
 
 class RecordSymbol : public SemSymbol{
 public:
-	RecordSymbol(std::string name, const RecordType * record)
+	RecordSymbol(Ident name, const RecordType * record)
 	: SemSymbol(name, record){ }
 	virtual SymbolKind getKind() const { return RECORD; }
 	SymbolKind getKind(){ return RECORD; }
 };
 
-//A single scope. The symbol table is broken down into a 
-// chain of scope tables, and each scope table holds 
-// semantic symbols for a single scope. For example,
-// the globals scope will be represented by a ScopeTable,
-// and the contents of each function can be represented by
-// a ScopeTable.
-class ScopeTable {
-	public:
-		ScopeTable();
-		SemSymbol * lookup(std::string name);
-		bool insert(SemSymbol * symbol);
-		bool clash(std::string name);
-		std::string toString();
-		void addVar(std::string name, const DataType * type){
-			insert(new VarSymbol(name, type));
-		}
-		void addFn(std::string name, FnType * type){
-			insert(new FnSymbol(name, type));
-		}
-	private:
-		HashMap<std::string, SemSymbol *> * symbols;
-};
-
+//The scoped symbol table. Rather than a chain of per-scope
+// maps, every binding lives in one flat table: each name
+// maps (by open addressing on its Ident) to the innermost
+// binding for that name, which links to the binding it 
+// shadows. Each scope is a run at the end of an undo log 
+// of the bindings made in it, so leaving a scope just
+// unwinds that run. A lookup is one probe regardless of
+// how deeply scopes are nested.
 class SymbolTable{
 	public:
 		SymbolTable();
-		ScopeTable * enterScope();
+		void enterScope();
 		void leaveScope();
-		ScopeTable * getCurrentScope();
 		bool insert(SemSymbol * symbol);
-		SemSymbol * find(std::string varName);
-		bool clash(std::string name);
-		void addVar(std::string name, const DataType * type){
-			getCurrentScope()->addVar(name, type);
+		SemSymbol * find(Ident varName);
+		bool clash(Ident name);
+		//As insert and clash, but acting on the scope 
+		// enclosing the current one (for example, to declare
+		// a function from within its own body scope)
+		bool insertEnclosing(SemSymbol * symbol);
+		bool clashEnclosing(Ident name);
+		void addVar(Ident name, const DataType * type){
+			insert(new VarSymbol(name, type));
 		}
-		void addFn(std::string name, FnType * type){
-			getCurrentScope()->addFn(name, type);
+		void addFn(Ident name, const FnType * type){
+			insert(new FnSymbol(name, type));
 		}
+		//The number of scopes currently open
+		size_t depth() const { return marks.size(); }
+		//The number of symbols ever inserted, in any scope
+		size_t numDeclared() const { return declared; }
 		void print();
 	private:
-		std::list<ScopeTable *> * scopeTableChain;
+		static const uint32_t NONE = UINT32_MAX;
+
+		struct Slot{
+			uint32_t key;     //Ident id + 1, or 0 if unused
+			uint32_t head;    //innermost binding, or NONE
+		};
+		struct Binding{
+			SemSymbol * sym;
+			uint32_t depth;
+			uint32_t shadowed; //next-outer binding, or NONE
+			uint32_t slot;
+		};
+
+		uint32_t slotFor(Ident name);
+		SemSymbol * findAtDepth(Ident name, size_t scopeDepth);
+		uint32_t newBinding(SemSymbol * sym, size_t scopeDepth);
+		void grow();
+
+		std::vector<Slot> slots;
+		size_t slotsUsed;
+		std::vector<Binding> bindings;
+		std::vector<uint32_t> freeBindings;
+		//Indices into bindings, in the order they were made
+		std::vector<uint32_t> undoLog;
+		//Length of undoLog when each open scope was entered
+		std::vector<size_t> marks;
+		size_t declared;
 };
 
 	
@@ -54,56 +54,56 @@ static std::string tokenKindString(int tokKind){
 	
 }
 
-Token::Token(Position * posIn, int kindIn)
+Token::Token(Position posIn, int kindIn)
   : myPos(posIn), myKind(kindIn){
 }
 
 std::string Token::toString(){
 	return tokenKindString(kind())
-	+ " " + myPos->begin();
+	+ " " + myPos.begin();
 }
 
 int Token::kind() const { 
 	return this->myKind; 
 }
 
-Position * Token::pos() const {
+Position Token::pos() const {
 	return myPos;
 }
 
-IDToken::IDToken(Position * posIn, std::string vIn)
+IDToken::IDToken(Position posIn, Ident vIn)
   : Token(posIn, TokenKind::ID), myValue(vIn){ 
 }
 
 std::string IDToken::toString(){
 	return tokenKindString(kind()) + ":"
-	+ myValue + " " + myPos->begin();
+	+ myValue.str() + " " + myPos.begin();
 }
 
-const std::string IDToken::value() const { 
+Ident IDToken::value() const { 
 	return this->myValue; 
 }
 
-StrToken::StrToken(Position * posIn, std::string sIn)
+StrToken::StrToken(Position posIn, TextView sIn)
   : Token(posIn, TokenKind::STRLITERAL), myStr(sIn){
 }
 
 std::string StrToken::toString(){
 	return tokenKindString(kind()) + ":"
-	+ this->myStr + " " + myPos->begin();
+	+ this->myStr.str() + " " + myPos.begin();
 }
 
 const std::string StrToken::str() const {
-	return this->myStr;
+	return this->myStr.str();
 }
 
-IntLitToken::IntLitToken(Position * pos, int numIn)
+IntLitToken::IntLitToken(Position pos, int numIn)
   : Token(pos, TokenKind::INTLITERAL), myNum(numIn){}
 
 std::string IntLitToken::toString(){
 	return tokenKindString(kind()) + ":"
 	+ std::to_string(this->myNum) + " "
-	+ myPos->begin();
+	+ myPos.begin();
 }
 
 int IntLitToken::num() const {
@@ -3,45 +3,47 @@
 
 #include <string>
 #include "position.hpp"
+#include "source_file.hpp"
+#include "intern.hpp"
 
 namespace cshanty{
 
 class Token{
 public:
-	Token(Position * pos, int kindIn);
+	Token(Position pos, int kindIn);
 	virtual std::string toString();
 	size_t line() const;
 	size_t col() const;
 	int kind() const;
-	Position * pos() const;
+	Position pos() const;
 protected:
-	Position * myPos;
+	Position myPos;
 private:
 	const int myKind;
 };
 
 class IDToken : public Token{
 public:
-	IDToken(Position * posIn, std::string valIn);
-	const std::string value() const;
+	IDToken(Position posIn, Ident valIn);
+	Ident value() const;
 	virtual std::string toString() override;
 private:
-	const std::string myValue;
+	const Ident myValue;
 	
 };
 
 class StrToken : public Token{
 public:
-	StrToken(Position * posIn, std::string valIn);
+	StrToken(Position posIn, TextView valIn);
 	virtual std::string toString() override;
 	const std::string str() const;
 private:
-	const std::string myStr;
+	const TextView myStr;
 };
 
 class IntLitToken : public Token{
 public:
-	IntLitToken(Position * posIn, int numIn);
+	IntLitToken(Position posIn, int numIn);
 	virtual std::string toString() override;
 	int num() const;
 private:
@@ -6,11 +6,9 @@
 namespace cshanty {
 
 TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
-	TypeAnalysis * typeAnalysis = new TypeAnalysis();
-	auto ast = nameAnalysis->ast;	
-	typeAnalysis->ast = ast;
+	TypeAnalysis * typeAnalysis = new TypeAnalysis(nameAnalysis->ast);
 
-	ast->typeAnalysis(typeAnalysis);
+	typeAnalysis->ast->typeAnalysis(typeAnalysis);
 	if (typeAnalysis->hasError){
 		return nullptr;
 	}
@@ -51,15 +49,14 @@ void FnDeclNode::typeAnalysis(TypeAnalysis * typing){
 	myRetType->typeAnalysis(typing);
 	const DataType * retDataType = typing->nodeType(myRetType);
 
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
+	std::list<const DataType *> formalTypes;
 	for (auto formal : *myFormals){
 		formal->typeAnalysis(typing);
-		formalTypes->push_back(typing->nodeType(formal));
+		formalTypes.push_back(typing->nodeType(formal));
 	}	
 
 	
-	typing->nodeType(this, new FnType(formalTypes, retDataType));
+	typing->nodeType(this, FnType::produce(formalTypes, retDataType));
 
 	typing->setCurrentFnType(typing->nodeType(this)->asFn());
 	for (auto stmt : *myBody){
@@ -169,10 +166,10 @@ void AssignExpNode::typeAnalysis(TypeAnalysis * typing){
 
 void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 
-	std::list<const DataType *> * aList = new std::list<const DataType *>();
+	std::list<const DataType *> aList;
 	for (auto actual : *myArgs){
 		actual->typeAnalysis(typing);
-		aList->push_back(typing->nodeType(actual));
+		aList.push_back(typing->nodeType(actual));
 	}
 
 	SemSymbol * calleeSym = myID->getSymbol();
@@ -186,15 +183,15 @@ void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 	}
 
 	const std::list<const DataType *>* fList = fnType->getFormalTypes();
-	if (aList->size() != fList->size()){
+	if (aList.size() != fList->size()){
 		typing->errArgCount(pos());
 		//Note: we still consider the call to return the 
 		// return type
 	} else {
-		auto actualTypesItr = aList->begin();
+		auto actualTypesItr = aList.begin();
 		auto formalTypesItr = fList->begin();
 		auto actualsItr = myArgs->begin();
-		while(actualTypesItr != aList->end()){
+		while(actualTypesItr != aList.end()){
 			const DataType * actualType = *actualTypesItr;
 			const DataType * formalType = *formalTypesItr;
 			ExpNode * actual = *actualsItr;
@@ -207,17 +204,10 @@ void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 			if (actualType->asError()){ continue; }
 			if (formalType->asError()){ continue; }
 
-			//Ok match
+			//Ok match. Types are flyweights, so this covers
+			// records and functions as well as basic types
 			if (formalType == actualType){ continue; }
 
-			const RecordType * formalRec = formalType->asRecord();
-			const RecordType * actualRec = actualType->asRecord();
-			if (formalRec && actualRec){
-				if (formalRec == actualRec){
-					continue;
-				}
-			}
-
 			//Bad match
 			typing->errArgMatch(actual->pos());
 			typing->nodeType(this, ErrorType::produce());
@@ -11,16 +11,17 @@ namespace cshanty{
 
 // An instance of this class will be passed over the entire
 // AST. Rather than attaching types to each node, the 
-// TypeAnalysis class contains a map from each ASTNode to it's
-// DataType. Thus, instead of attaching a type field to most nodes,
-// one can instead map the node to it's type, or lookup the node
-// in the map.
+// TypeAnalysis class contains a table from each ASTNode to it's
+// DataType, indexed by the node's id. Thus, instead of attaching
+// a type field to most nodes, one can instead map the node to 
+// it's type, or lookup the node in the table.
 class TypeAnalysis {
 
 private:
 	//The private constructor here means that the type analysis
 	// can only be created via the static build function
-	TypeAnalysis(){
+	TypeAnalysis(ProgramNode * astIn)
+	: nodeTypes(astIn->nodeCount(), nullptr), ast(astIn){
 		hasError = false;
 	}
 
@@ -47,181 +48,180 @@ public:
 	
 	//Set the type of a node. Note that the function name is 
 	// overloaded: this 2-argument nodeType puts a value into the
-	// map with a given type. 
+	// table with a given type. 
 	void nodeType(const ASTNode * node, const DataType * type){
-		nodeToType[node] = type;
+		nodeTypes[node->id()] = type;
 	}
 
-	//Gets the type of a node already placed in the map. Note
+	//Gets the type of a node already placed in the table. Note
 	// that this function name is overloaded: the 1-argument nodeType
-	// gets the type of the given node out of the map.
+	// gets the type of the given node out of the table.
 	const DataType * nodeType(const ASTNode * node){
-		auto res = nodeToType.find(node);
-		assert(res != nodeToType.end() || "No type for node");
+		assert(node->id() < nodeTypes.size() && "No type for node");
 		
 		//Note: this actually could be nullptr
-		return res->second;
+		return nodeTypes[node->id()];
 	}
 
 	//The following functions all report and error and 
 	// tell the object that the analysis has failed. 
-	void errWriteFn(Position * pos){
+	void errWriteFn(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to output a function");
 	}
-	void errWriteVoid(Position * pos){
+	void errWriteVoid(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Attempt to write void");
 	}
-	void errReportRecName(Position * pos){
+	void errReportRecName(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to report record name");
 	}
-	void errReportRecVar(Position * pos){
+	void errReportRecVar(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to output a record variable");
 	}
-	void errReceiveRecVar(Position * pos){
+	void errReceiveRecVar(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to read a record variable");
 	}
-	void errReceiveRecName(Position * pos){
+	void errReceiveRecName(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to read a record name");
 	}
-	void errReadFn(Position * pos){
+	void errReadFn(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attemp to assign input to function");
 	}
-	void errReadOther(Position * pos){
+	void errReadOther(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to read to illegal type");
 	}
-	void errCallee(Position * pos){
+	void errCallee(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Attempt to call a "
 			"non-function");
 	}
-	void errArgCount(Position * pos){
+	void errArgCount(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Function call with wrong"
 			" number of args");
 	}
-	void errArgMatch(Position * pos){
+	void errArgMatch(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Type of actual does not match"
 			" type of formal");
 	}
-	void errRetEmpty(Position * pos){
+	void errRetEmpty(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Missing return value");
 	}
-	void extraRetValue(Position * pos){
+	void extraRetValue(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Return with a value in void"
 			" function");
 	}
-	void errRetWrong(Position * pos){
+	void errRetWrong(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Bad return value");
 	}
-	void errMathOpd(Position * pos){
+	void errMathOpd(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Arithmetic operator applied"
 			" to invalid operand");
 	}
-	void errRelOpd(Position * pos){
+	void errRelOpd(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Relational operator applied to"
 			" non-numeric operand");
 	}
-	void errLogicOpd(Position * pos){
+	void errLogicOpd(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Logical operator applied to"
 			" non-bool operand");
 	}
-	void errIfCond(Position * pos){
+	void errIfCond(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Non-bool expression used as"
 			" an if condition");
 	}
-	void errWhileCond(Position * pos){
+	void errWhileCond(Position pos){
 		hasError = true;
 		Report::fatal(pos,
 			"Non-bool expression used as"
 			" a while condition");
 	}
-	void errEqOpd(Position * pos){
+	void errEqOpd(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Invalid equality operand");
 	}
-	void errEqOpr(Position * pos){
+	void errEqOpr(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Invalid equality operation");
 	}
-	void errEqRecVars(Position * pos){
+	void errEqRecVars(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Equality operator applied to record variables");
 	}
-	void errEqRecNames(Position * pos){
+	void errEqRecNames(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Equality operator applied to record names");
 	}
-	void errAssignOpd(Position * pos){
+	void errAssignOpd(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Invalid assignment operand");
 	}
-	void errAssignOpr(Position * pos){
+	void errAssignOpr(Position pos){
 		hasError = true;
 		Report::fatal(pos, 
 			"Invalid assignment operation");
 	}
-	void errAssignRecVar(Position * pos){
+	void errAssignRecVar(Position pos){
 		hasError = true;
 		Report::fatal(pos, "Record variable assignment");
 	}
-	void errAssignRecName(Position * pos){
+	void errAssignRecName(Position pos){
 		hasError = true;
 		Report::fatal(pos, "Record name assignment");
 	}
-	void errAssignFn(Position * pos){
+	void errAssignFn(Position pos){
 		hasError = true;
 		Report::fatal(pos, "Invalid assignment operation");
 	}
-	void errRecordID(Position * pos){
+	void errRecordID(Position pos){
 		hasError = true;
 		Report::fatal(pos, "Attempt to index a non-record");
 	}
 
-	void errRecordIndex(Position * pos){
+	void errRecordIndex(Position pos){
 		hasError = true;
 		Report::fatal(pos, "Bad index");
 	}
 private:
-	HashMap<const ASTNode *, const DataType *> nodeToType;
+	std::vector<const DataType *> nodeTypes;
 	const FnType * currentFnType;
 	bool hasError;
 public:
@@ -1,5 +1,7 @@
 #include <list>
+#include <mutex>
 #include <sstream>
+#include <vector>
 
 #include "types.hpp"
 #include "ast.hpp"
@@ -25,6 +27,44 @@ std::string BasicType::getString() const{
 	return res;
 }
 
+//A function signature as a flat key: the return type,
+// followed by each formal type in order
+typedef std::vector<const DataType *> Signature;
+
+struct SignatureHash{
+	size_t operator()(const Signature& sig) const{
+		size_t h = sig.size();
+		for (const DataType * type : sig){
+			h ^= std::hash<const DataType *>()(type) 
+				+ 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+		}
+		return h;
+	}
+};
+
+const FnType * FnType::produce(
+	const std::list<const DataType *>& formals, 
+	const DataType * retType){
+	//Function types are shared by every compilation in the
+	// process, which may be running on several threads
+	static std::mutex lock;
+	static std::unordered_map<Signature, FnType *, SignatureHash> flyweights;
+
+	Signature key;
+	key.reserve(formals.size() + 1);
+	key.push_back(retType);
+	key.insert(key.end(), formals.begin(), formals.end());
+
+	std::lock_guard<std::mutex> guard(lock);
+	auto found = flyweights.find(key);
+	if (found != flyweights.end()){
+		return found->second;
+	}
+	FnType * newType = new FnType(formals, retType);
+	flyweights.emplace(std::move(key), newType);
+	return newType;
+}
+
 const DataType * StringTypeNode::getType() { 
 	return BasicType::STRING(); 
 }
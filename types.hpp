@@ -4,6 +4,7 @@
 #include <list>
 #include <sstream>
 #include "errors.hpp"
+#include "intern.hpp"
 
 #include <unordered_map>
 
@@ -100,7 +101,7 @@ public:
 	// and ensures that the memory needs of a program are kept
 	// down: rather than having a distinct type for every base
 	// INT (for example), only one is constructed and kept in
-	// the flyweights list. That type is then re-used anywhere
+	// the flyweights table. That type is then re-used anywhere
 	// it's needed. 
 
 	//Note the use of the static function declaration, which 
@@ -111,16 +112,15 @@ public:
 		//means that the flyweights variable persists between
 		// multiple calls to this function (it is essentially
 		// a global variable that can only be accessed
-		// in this function).
-		static std::list<BasicType *> flyweights;
-		for(BasicType * fly : flyweights){
-			if (fly->getBaseType() == base){
-				return fly;
-			}
-		}
-		BasicType * newType = new BasicType(base);
-		flyweights.push_back(newType);
-		return newType;
+		// in this function). The table is in BaseType order,
+		// so finding a type is a single index.
+		static BasicType flyweights[] = {
+			BasicType(BaseType::INT),
+			BasicType(BaseType::VOID),
+			BasicType(BaseType::STRING),
+			BasicType(BaseType::BOOL),
+		};
+		return &flyweights[base];
 	}
 	const BasicType * asBasic() const override {
 		return this;
@@ -147,7 +147,7 @@ public:
 	virtual std::string getString() const override;
 	virtual size_t getSize() const override { 
 		if (isBool()){ return 1; }
-		else if (isString()){ throw new ToDoError("Implement me"); }
+		else if (isString()){ return 8; }
 		else if (isVoid()){ return 8; }
 		else if (isInt()){ return 8; }
 		else { return 0; }
@@ -158,56 +158,63 @@ private:
 	BaseType myBaseType;
 };
 
+//Record types are nominal: each record declaration
+// produces its own type, which belongs to the compilation
+// that declared it. (Name analysis rejects a second 
+// declaration of the same name, so within a compilation a
+// name still means one type.)
 class RecordType : public DataType{
 public:
-	//static RecordType * produce(std::list<DataType *>, std::string name){
-	static RecordType * produce(std::string name, HashMap<std::string, const DataType *> * fields){
-		static HashMap <std::string, RecordType *> map;
-
-		//TODO: find a node
-		RecordType * r;
-		auto res = map.find(name);
-		if (res == map.end()){
-			RecordType * r = new RecordType(name, fields);
-			map[name] = r;
-			return r;
-		} else {
-			return res->second;
-		}
+	//fieldNames holds the keys of fields in declaration order
+	static RecordType * produce(std::string name, HashMap<Ident, const DataType *> * fields,
+		std::vector<Ident> fieldNames){
+		return new RecordType(name, fields, fieldNames);
 	};
 	bool validVarType() const override { return true; }
 	std::string getString() const override { return name; }
-	size_t getSize() const override { TODO(Implement); }
+	size_t getSize() const override { 
+		size_t size = 0;
+		for (auto field : *fieldTypes){
+			size += field.second->getSize();
+		}
+		return size;
+	}
 	const RecordType * asRecord() const override { return this; }
 	bool isRecord() const override { return true; }
 
-	const DataType * getField(std::string fieldName) const{
+	const DataType * getField(Ident fieldName) const{
 		auto res = fieldTypes->find(fieldName);
 		if (res == fieldTypes->end()){ return nullptr; }
 		return res->second;
 	}
+	const std::vector<Ident>& getFieldNames() const { return fieldNames; }
 private:
-	RecordType(std::string nameIn, HashMap<std::string, const DataType *> * fieldsIn) 
-	: name(nameIn), fieldTypes(fieldsIn){ 
+	RecordType(std::string nameIn, HashMap<Ident, const DataType *> * fieldsIn,
+		std::vector<Ident> fieldNamesIn) 
+	: name(nameIn), fieldTypes(fieldsIn), fieldNames(fieldNamesIn){ 
 	}
 	std::string name;
-	HashMap<std::string, const DataType *> *fieldTypes;
+	HashMap<Ident, const DataType *> *fieldTypes;
+	std::vector<Ident> fieldNames;
 };
 
 //DataType subclass to represent the type of a function. It will
 // have a list of argument types and a return type. 
 class FnType : public DataType{
 public:
-	FnType(const std::list<const DataType *>* formalsIn, const DataType * retTypeIn) 
-	: DataType(),
-	  myFormalTypes(formalsIn),
-	  myRetType(retTypeIn)
-	{
-	}
+	//Like BasicType, function types are flyweights: there is
+	// one FnType per distinct signature, found by hashing the
+	// formal and return types. Since the component types are
+	// flyweights too, two function types are equal exactly 
+	// when their pointers are.
+	static const FnType * produce(
+		const std::list<const DataType *>& formals, 
+		const DataType * retType);
+
 	std::string getString() const override{
 		std::string result = "";
 		bool first = true;
-		for (auto elt : *myFormalTypes){
+		for (auto elt : myFormalTypes){
 			if (first) { first = false; }
 			else { result += ","; }
 			result += elt->getString();
@@ -222,12 +229,18 @@ public:
 		return myRetType;
 	}
 	const std::list<const DataType *> * getFormalTypes() const {
-		return myFormalTypes;
+		return &myFormalTypes;
 	}
 	virtual bool validVarType() const override { return false; }
 	virtual size_t getSize() const override { return 0; }
 private:
-	const std::list<const DataType *> * myFormalTypes;
+	FnType(const std::list<const DataType *>& formalsIn, const DataType * retTypeIn) 
+	: DataType(),
+	  myFormalTypes(formalsIn),
+	  myRetType(retTypeIn)
+	{
+	}
+	const std::list<const DataType *> myFormalTypes;
 	const DataType * myRetType;
 };
 
@@ -0,0 +1,133 @@
+#ifndef CSHANTY_X64_HPP
+#define CSHANTY_X64_HPP
+
+#include <stdint.h>
+#include <vector>
+#include "3ac.hpp"
+
+namespace cshanty{
+
+//What the two x86-64 backends share. x64_codegen.cpp lowers
+// each procedure to instructions, which an X64Emitter writes
+// out: as GNU assembly (-o, in x64_codegen.cpp) or as
+// machine code in memory (--jit, in jit.cpp). Code follows
+// the System V convention, keeps allocated registers in the
+// same places and lays out frames the same way either way.
+
+//Machine registers, numbered by their encoding
+enum class Reg : uint8_t{
+	RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+	R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+//Arguments passed in registers; the rest go on the stack
+static const size_t NUM_ARG_REGS = 6;
+static const Reg ARG_REGS[NUM_ARG_REGS] = {
+	Reg::RDI, Reg::RSI, Reg::RDX, Reg::RCX, Reg::R8, Reg::R9
+};
+//The registers register allocation may use (see
+// regalloc.hpp), r0 first. The first five are callee-saved.
+static const size_t NUM_ALLOC_REGS = 7;
+static const size_t NUM_CALLEE_SAVED = 5;
+static const Reg ALLOC_REGS[NUM_ALLOC_REGS] = {
+	Reg::RBX, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::R10, Reg::R11
+};
+
+//A procedure's frame, from %rbp down:
+//  - the first six incoming arguments, copied out of their
+//    registers by the prologue (GETARG reads them there)
+//  - the callee-saved registers it uses
+//  - a slot for each formal, local and temp the body names
+//  - space for the outgoing stack arguments of the largest
+//    call, at the bottom so the callee finds them at 16(%rbp)
+//The frame is padded so %rsp stays 16-byte aligned at calls.
+class X64Frame{
+public:
+	explicit X64Frame(Procedure * proc);
+
+	//The %rbp-relative offset of opd's slot, or 0 if it has
+	// none (constants, globals and registers)
+	int64_t offsetOf(OpdID opd) const { return offsets[opd]; }
+	//Where GETARG finds argument idx (counting from 1)
+	static int64_t argOffset(size_t idx){
+		if (idx <= NUM_ARG_REGS){ return -static_cast<int64_t>(idx * 8); }
+		return static_cast<int64_t>(16 + (idx - NUM_ARG_REGS - 1) * 8);
+	}
+	//Where SETARG puts argument idx (past the sixth), from %rsp
+	static int64_t outArgOffset(size_t idx){
+		return static_cast<int64_t>((idx - NUM_ARG_REGS - 1) * 8);
+	}
+	//Where the prologue saves allocated register reg
+	int64_t savedOffset(size_t reg) const {
+		return -static_cast<int64_t>((myNumHomes + reg + 1) * 8);
+	}
+	//Incoming arguments the prologue copies out of registers
+	size_t numHomes() const { return myNumHomes; }
+	//How many allocated registers, from r0, need saving
+	size_t numSaved() const { return myNumSaved; }
+	//Bytes to subtract from %rsp after pushing %rbp
+	size_t size() const { return mySize; }
+private:
+	std::vector<int64_t> offsets;
+	size_t myNumHomes;
+	size_t myNumSaved;
+	size_t mySize;
+};
+
+//Two-operand instructions: dst = dst op src (CMP and TEST
+// only set the flags)
+enum class Alu : uint8_t{ ADD, SUB, IMUL, AND, OR, XOR, CMP, TEST };
+//Conditions for setcc and jcc, after a CMP of a with b (cmpq
+// b, a): a == b, a != b, a < b, and so on, signed
+enum class Cond : uint8_t{ E, NE, L, G, LE, GE };
+//The runtime's functions (stdcshanty.c, or the JIT's own)
+enum class RuntimeFn : uint8_t{
+	PRINT_INT, PRINT_BOOL, PRINT_STRING, GET_INT, GET_BOOL
+};
+
+//Where the x64 lowering puts its instructions: a sink of
+// assembly text (-o) or of machine code (--jit). Each call
+// is one instruction (divide and setcc are two), so the lowering decides
+// everything and a sink only spells it out.
+class X64Emitter{
+public:
+	virtual ~X64Emitter(){ }
+	//Say which quad the code that follows is for
+	virtual void annotate(const Quad&){ }
+	virtual void label(LabelID label) = 0;
+	virtual void push(Reg reg) = 0;
+	virtual void pop(Reg reg) = 0;
+	virtual void ret() = 0;
+	virtual void mov(Reg src, Reg dst) = 0;
+	virtual void movImm(int64_t val, Reg dst) = 0;
+	//Memory at disp(base), where base is %rbp or %rsp (for
+	// stores only)
+	virtual void load(Reg base, int64_t disp, Reg dst) = 0;
+	virtual void store(Reg src, Reg base, int64_t disp) = 0;
+	virtual void loadGlobal(SemSymbol * global, Reg dst) = 0;
+	virtual void storeGlobal(Reg src, SemSymbol * global) = 0;
+	//The address of string literal num
+	virtual void leaString(uint32_t num, Reg dst) = 0;
+	virtual void alu(Alu op, Reg src, Reg dst) = 0;
+	//op with a 32-bit immediate, for ADD to CMP but IMUL
+	virtual void aluImm(Alu op, int32_t imm, Reg dst) = 0;
+	virtual void neg(Reg reg) = 0;
+	//cqto; idivq divisor: %rax / divisor, in %rax
+	virtual void divide(Reg divisor) = 0;
+	//setcc %al; movzbq %al, %rax
+	virtual void setcc(Cond cond) = 0;
+	virtual void jmp(LabelID target) = 0;
+	virtual void jcc(Cond cond, LabelID target) = 0;
+	virtual void call(SemSymbol * fn) = 0;
+	//Call a runtime function, with its argument (if any) in
+	// %rdi and its result (if any) in %rax
+	virtual void callRuntime(RuntimeFn fn) = 0;
+};
+
+//Lower proc, which must be out of SSA form, to em: the
+// prologue, every quad of the body and the epilogue
+void lowerX64(Procedure * proc, X64Emitter& em);
+
+}
+
+#endif
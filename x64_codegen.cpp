@@ -0,0 +1,450 @@
+#include <algorithm>
+#include <ostream>
+#include <stdint.h>
+#include "x64.hpp"
+
+namespace cshanty{
+
+//Lowering of the 3AC to x86-64, for Linux, and the emitter
+// that writes it as GNU assembly (AT&T syntax). Every
+// operand lives in memory: globals in the data section,
+// everything else in its procedure's frame. Each quad loads
+// its sources into %rax/%rcx, computes and stores its
+// result, so no value is held in a register from one quad to
+// the next, except in the registers handed out by register
+// allocation. None of those is touched by the lowering of
+// any quad.
+//
+//Calls follow the System V convention, so the runtime
+// (stdcshanty.c) can be plain C. Frames are laid out as
+// described in x64.hpp.
+
+X64Frame::X64Frame(Procedure * proc)
+: offsets(proc->numOpds(), 0), myNumHomes(0), myNumSaved(0), mySize(0){
+	size_t numArgs = proc->getFormals().size();
+	size_t outArgs = 0;
+	for (const Quad& quad : proc->getBody()){
+		if (quad.getOp() == QuadOp::GETARG && quad.getIndex() > numArgs){
+			numArgs = quad.getIndex();
+		}
+		if (quad.getOp() == QuadOp::SETARG && quad.getIndex() > NUM_ARG_REGS){
+			outArgs = std::max(outArgs, quad.getIndex() - NUM_ARG_REGS);
+		}
+	}
+	myNumHomes = std::min(numArgs, NUM_ARG_REGS);
+
+	std::vector<bool> named(proc->numOpds(), false);
+	for (const Quad& quad : proc->getBody()){
+		for (OpdID opd : {quad.getDst(), quad.getSrc1(), quad.getSrc2()}){
+			if (opd == NO_OPD){ continue; }
+			named[opd] = true;
+			const Opd& reg = proc->getOpd(opd);
+			if (reg.getKind() != OpdKind::REG){ continue; }
+			if (reg.getNum() >= NUM_ALLOC_REGS){
+				//main rejects --regs above this for -o and --jit
+				throw new InternalError("More registers allocated than x64 has");
+			}
+			myNumSaved = std::max(myNumSaved,
+				std::min<size_t>(reg.getNum() + 1, NUM_CALLEE_SAVED));
+		}
+	}
+
+	size_t used = (myNumHomes + myNumSaved) * 8;
+	for (const std::vector<OpdID> * vars :
+	  {&proc->getFormals(), &proc->getLocals(), &proc->getTemps()}){
+		for (OpdID var : *vars){
+			if (offsets[var] != 0 || !named[var]){ continue; }
+			used += 8;
+			offsets[var] = -static_cast<int64_t>(used);
+		}
+	}
+	used += outArgs * 8;
+	mySize = (used + 15) / 16 * 16;
+}
+
+//Lowers one procedure to an emitter
+class X64Lowering{
+public:
+	X64Lowering(Procedure * procIn, X64Emitter& emIn)
+	: proc(procIn), em(emIn), frame(procIn){ }
+	void lower();
+private:
+	void lowerQuad(const Quad& quad);
+	void lowerBinOp(const Quad& quad);
+	//Load opd's value into reg, or store reg into opd
+	void load(OpdID opd, Reg reg);
+	void store(Reg reg, OpdID opd);
+	//Whether opd is a REG operand, and if so its register
+	bool regOf(OpdID opd, Reg& reg);
+
+	Procedure * proc;
+	X64Emitter& em;
+	X64Frame frame;
+};
+
+bool X64Lowering::regOf(OpdID opd, Reg& reg){
+	const Opd& info = proc->getOpd(opd);
+	if (info.getKind() != OpdKind::REG){ return false; }
+	reg = ALLOC_REGS[info.getNum()];
+	return true;
+}
+
+void X64Lowering::load(OpdID opdID, Reg reg){
+	const Opd& opd = proc->getOpd(opdID);
+	switch (opd.getKind()){
+	case OpdKind::REG:
+		if (ALLOC_REGS[opd.getNum()] != reg){
+			em.mov(ALLOC_REGS[opd.getNum()], reg);
+		}
+		return;
+	case OpdKind::LIT:
+		em.movImm(opd.getValue(), reg);
+		return;
+	case OpdKind::STR:
+		em.leaString(opd.getNum(), reg);
+		return;
+	case OpdKind::SYM:
+		if (proc->getProg()->isGlobal(opd.getSym())){
+			em.loadGlobal(opd.getSym(), reg);
+			return;
+		}
+		break;
+	case OpdKind::TMP:
+		break;
+	case OpdKind::ADDR:
+		throw new ToDoError("Address operands have no x64 lowering");
+	}
+	if (frame.offsetOf(opdID) == 0){
+		throw new InternalError("Operand has no frame slot");
+	}
+	em.load(Reg::RBP, frame.offsetOf(opdID), reg);
+}
+
+void X64Lowering::store(Reg reg, OpdID opdID){
+	const Opd& opd = proc->getOpd(opdID);
+	Reg dst;
+	if (regOf(opdID, dst)){
+		if (dst != reg){ em.mov(reg, dst); }
+		return;
+	}
+	if (opd.getKind() == OpdKind::SYM
+	  && proc->getProg()->isGlobal(opd.getSym())){
+		em.storeGlobal(reg, opd.getSym());
+		return;
+	}
+	if (frame.offsetOf(opdID) == 0){
+		throw new InternalError("Operand has no frame slot");
+	}
+	em.store(reg, Reg::RBP, frame.offsetOf(opdID));
+}
+
+void X64Lowering::lowerBinOp(const Quad& quad){
+	load(quad.getSrc1(), Reg::RAX);
+	load(quad.getSrc2(), Reg::RCX);
+	Cond cond;
+	switch (quad.getBinOp()){
+	case ADD64: em.alu(Alu::ADD, Reg::RCX, Reg::RAX); break;
+	case SUB64: em.alu(Alu::SUB, Reg::RCX, Reg::RAX); break;
+	case MULT64: em.alu(Alu::IMUL, Reg::RCX, Reg::RAX); break;
+	case DIV64: em.divide(Reg::RCX); break;
+	case AND64: em.alu(Alu::AND, Reg::RCX, Reg::RAX); break;
+	case OR64: em.alu(Alu::OR, Reg::RCX, Reg::RAX); break;
+	case EQ64: cond = Cond::E; goto compare;
+	case NEQ64: cond = Cond::NE; goto compare;
+	case LT64: cond = Cond::L; goto compare;
+	case GT64: cond = Cond::G; goto compare;
+	case LTE64: cond = Cond::LE; goto compare;
+	case GTE64: cond = Cond::GE; goto compare;
+	compare:
+		em.alu(Alu::CMP, Reg::RCX, Reg::RAX);
+		em.setcc(cond);
+		break;
+	}
+	store(Reg::RAX, quad.getDst());
+}
+
+//The runtime function moving a value of the given type
+static RuntimeFn runtimeFn(const DataType * type, bool input){
+	if (type->isBool()){ return input ? RuntimeFn::GET_BOOL : RuntimeFn::PRINT_BOOL; }
+	if (type->isInt()){ return input ? RuntimeFn::GET_INT : RuntimeFn::PRINT_INT; }
+	if (type->isString() && !input){ return RuntimeFn::PRINT_STRING; }
+	throw new InternalError("No runtime function for this type");
+}
+
+void X64Lowering::lowerQuad(const Quad& quad){
+	switch (quad.getOp()){
+	case QuadOp::ASSIGN: {
+		//A register on either side saves going through %rax
+		Reg reg;
+		if (regOf(quad.getDst(), reg)){
+			load(quad.getSrc(), reg);
+		} else if (regOf(quad.getSrc(), reg)){
+			store(reg, quad.getDst());
+		} else {
+			load(quad.getSrc(), Reg::RAX);
+			store(Reg::RAX, quad.getDst());
+		}
+		return;
+	}
+	case QuadOp::BINOP:
+		lowerBinOp(quad);
+		return;
+	case QuadOp::UNARYOP:
+		load(quad.getSrc(), Reg::RAX);
+		if (quad.getUnaryOp() == NEG64){
+			em.neg(Reg::RAX);
+		} else {
+			em.aluImm(Alu::XOR, 1, Reg::RAX);
+		}
+		store(Reg::RAX, quad.getDst());
+		return;
+	case QuadOp::INDEX:
+		throw new ToDoError("Record fields have no x64 lowering");
+	case QuadOp::GOTO:
+		em.jmp(quad.getTarget());
+		return;
+	case QuadOp::IFZ:
+		load(quad.getSrc(), Reg::RAX);
+		em.alu(Alu::TEST, Reg::RAX, Reg::RAX);
+		em.jcc(Cond::E, quad.getTarget());
+		return;
+	case QuadOp::NOP:
+		return;
+	case QuadOp::REPORT:
+		load(quad.getSrc(), ARG_REGS[0]);
+		em.callRuntime(runtimeFn(quad.getType(), false));
+		return;
+	case QuadOp::RECEIVE:
+		em.callRuntime(runtimeFn(quad.getType(), true));
+		store(Reg::RAX, quad.getDst());
+		return;
+	case QuadOp::CALL:
+		em.call(proc->getOpd(quad.getSrc1()).getSym());
+		return;
+	case QuadOp::SETARG: {
+		size_t idx = quad.getIndex();
+		if (idx <= NUM_ARG_REGS){
+			load(quad.getSrc(), ARG_REGS[idx - 1]);
+		} else {
+			load(quad.getSrc(), Reg::RAX);
+			em.store(Reg::RAX, Reg::RSP, X64Frame::outArgOffset(idx));
+		}
+		return;
+	}
+	case QuadOp::GETARG:
+		em.load(Reg::RBP, X64Frame::argOffset(quad.getIndex()), Reg::RAX);
+		store(Reg::RAX, quad.getDst());
+		return;
+	case QuadOp::SETRET:
+		load(quad.getSrc(), Reg::RAX);
+		return;
+	case QuadOp::GETRET:
+		store(Reg::RAX, quad.getDst());
+		return;
+	case QuadOp::ENTER:
+	case QuadOp::LEAVE:
+	case QuadOp::PHI:
+		break;
+	}
+	throw new InternalError("Quad can't be lowered to x64");
+}
+
+void X64Lowering::lower(){
+	bool returns = false;
+	for (const Quad& quad : proc->getBody()){
+		if (quad.getOp() == QuadOp::SETRET){ returns = true; }
+	}
+
+	em.label(ENTRY_LABEL);
+	em.push(Reg::RBP);
+	em.mov(Reg::RSP, Reg::RBP);
+	if (frame.size() > 0){
+		em.aluImm(Alu::SUB, static_cast<int32_t>(frame.size()), Reg::RSP);
+	}
+	for (size_t i = 0; i < frame.numHomes(); i++){
+		em.store(ARG_REGS[i], Reg::RBP, X64Frame::argOffset(i + 1));
+	}
+	for (size_t i = 0; i < frame.numSaved(); i++){
+		em.store(ALLOC_REGS[i], Reg::RBP, frame.savedOffset(i));
+	}
+
+	for (const Quad& quad : proc->getBody()){
+		if (quad.getLabel() != NO_LABEL){ em.label(quad.getLabel()); }
+		em.annotate(quad);
+		lowerQuad(quad);
+	}
+
+	em.label(proc->getLeaveLabel());
+	//main's result is the exit status, even if it has none
+	if (proc->getName() == "main" && !returns){
+		em.movImm(0, Reg::RAX);
+	}
+	for (size_t i = 0; i < frame.numSaved(); i++){
+		em.load(Reg::RBP, frame.savedOffset(i), ALLOC_REGS[i]);
+	}
+	em.mov(Reg::RBP, Reg::RSP);
+	em.pop(Reg::RBP);
+	em.ret();
+}
+
+void lowerX64(Procedure * proc, X64Emitter& em){
+	X64Lowering lowering(proc, em);
+	lowering.lower();
+}
+
+static const char * const REG_NAMES[] = {
+	"%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+	"%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"
+};
+
+static const char * name(Reg reg){
+	return REG_NAMES[static_cast<size_t>(reg)];
+}
+
+static const char * suffix(Cond cond){
+	switch (cond){
+	case Cond::E: return "e";
+	case Cond::NE: return "ne";
+	case Cond::L: return "l";
+	case Cond::G: return "g";
+	case Cond::LE: return "le";
+	case Cond::GE: return "ge";
+	}
+	throw new InternalError("Bad condition");
+}
+
+//Writes one procedure's instructions as assembly, with each
+// quad's 3AC as a comment
+class AsmEmitter : public X64Emitter{
+public:
+	AsmEmitter(Procedure * procIn, std::ostream& outIn)
+	: proc(procIn), out(outIn){ }
+
+	void annotate(const Quad& quad) override{
+		out << "\t# ";
+		quad.repr(out, proc);
+		out << "\n";
+	}
+	void label(LabelID label) override{
+		if (label == ENTRY_LABEL){ out << "\n"; }
+		proc->emitLabel(out, label);
+		out << ":\n";
+	}
+	void push(Reg reg) override{ out << "\tpushq " << name(reg) << "\n"; }
+	void pop(Reg reg) override{ out << "\tpopq " << name(reg) << "\n"; }
+	void ret() override{ out << "\tret\n"; }
+	void mov(Reg src, Reg dst) override{
+		out << "\tmovq " << name(src) << ", " << name(dst) << "\n";
+	}
+	void movImm(int64_t val, Reg dst) override{
+		if (val >= INT32_MIN && val <= INT32_MAX){
+			out << "\tmovq $" << val << ", " << name(dst) << "\n";
+		} else {
+			out << "\tmovabsq $" << val << ", " << name(dst) << "\n";
+		}
+	}
+	void load(Reg base, int64_t disp, Reg dst) override{
+		out << "\tmovq " << disp << "(" << name(base) << "), " << name(dst) << "\n";
+	}
+	void store(Reg src, Reg base, int64_t disp) override{
+		out << "\tmovq " << name(src) << ", " << disp << "(" << name(base) << ")\n";
+	}
+	void loadGlobal(SemSymbol * global, Reg dst) override{
+		out << "\tmovq gbl_" << global->getName() << "(%rip), " << name(dst) << "\n";
+	}
+	void storeGlobal(Reg src, SemSymbol * global) override{
+		out << "\tmovq " << name(src) << ", gbl_" << global->getName() << "(%rip)\n";
+	}
+	void leaString(uint32_t num, Reg dst) override{
+		out << "\tleaq str_" << num << "(%rip), " << name(dst) << "\n";
+	}
+	void alu(Alu op, Reg src, Reg dst) override{
+		out << "\t" << mnemonic(op) << " " << name(src) << ", " << name(dst) << "\n";
+	}
+	void aluImm(Alu op, int32_t imm, Reg dst) override{
+		out << "\t" << mnemonic(op) << " $" << imm << ", " << name(dst) << "\n";
+	}
+	void neg(Reg reg) override{ out << "\tnegq " << name(reg) << "\n"; }
+	void divide(Reg divisor) override{
+		out << "\tcqto\n\tidivq " << name(divisor) << "\n";
+	}
+	void setcc(Cond cond) override{
+		out << "\tset" << suffix(cond) << " %al\n\tmovzbq %al, %rax\n";
+	}
+	void jmp(LabelID target) override{
+		out << "\tjmp ";
+		proc->emitLabel(out, target);
+		out << "\n";
+	}
+	void jcc(Cond cond, LabelID target) override{
+		out << "\tj" << suffix(cond) << " ";
+		proc->emitLabel(out, target);
+		out << "\n";
+	}
+	void call(SemSymbol * fn) override{
+		if (fn->getName() == "main"){
+			out << "\tcall main\n";
+		} else {
+			out << "\tcall fun_" << fn->getName() << "\n";
+		}
+	}
+	void callRuntime(RuntimeFn fn) override{
+		out << "\tcall " << runtimeName(fn) << "\n";
+	}
+private:
+	static const char * mnemonic(Alu op){
+		switch (op){
+		case Alu::ADD: return "addq";
+		case Alu::SUB: return "subq";
+		case Alu::IMUL: return "imulq";
+		case Alu::AND: return "andq";
+		case Alu::OR: return "orq";
+		case Alu::XOR: return "xorq";
+		case Alu::CMP: return "cmpq";
+		case Alu::TEST: return "testq";
+		}
+		throw new InternalError("Bad ALU operation");
+	}
+	static const char * runtimeName(RuntimeFn fn){
+		switch (fn){
+		case RuntimeFn::PRINT_INT: return "printInt";
+		case RuntimeFn::PRINT_BOOL: return "printBool";
+		case RuntimeFn::PRINT_STRING: return "printString";
+		case RuntimeFn::GET_INT: return "getInt";
+		case RuntimeFn::GET_BOOL: return "getBool";
+		}
+		throw new InternalError("Bad runtime function");
+	}
+
+	Procedure * proc;
+	std::ostream& out;
+};
+
+void Procedure::toX64(std::ostream& out){
+	AsmEmitter emitter(this, out);
+	lowerX64(this, emitter);
+}
+
+void IRProgram::toX64(std::ostream& out){
+	if (!globals.empty()){
+		out << "\t.data\n\t.p2align 3\n";
+		for (SemSymbol * global : globals){
+			out << "gbl_" << global->getName() << ":\n\t.quad 0\n";
+		}
+	}
+	if (!strings.empty()){
+		out << "\t.section .rodata\n";
+		for (size_t i = 0; i < strings.size(); i++){
+			//cshanty's escapes (\n \t \" \\) mean the same to as
+			out << "str_" << i << ":\n\t.asciz " << strings[i] << "\n";
+		}
+	}
+	out << "\t.text\n\t.globl main\n";
+	for (Procedure * proc : *procs){
+		proc->toX64(out);
+	}
+	//The stack needn't be executable
+	out << "\t.section .note.GNU-stack,\"\",@progbits\n";
+}
+
+}